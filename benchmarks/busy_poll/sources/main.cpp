@@ -0,0 +1,153 @@
+/*
+ * Request latency with the I/O thread blocking in epoll_wait vs. busy
+ * polling. One client sends requests one after another over loopback,
+ * each on a new connection, optionally pausing between them; the server
+ * runs one I/O thread.
+ *
+ * Usage: busy_poll_benchmark [requests] [budget_us] [gap_us] [port]
+ *
+ * Busy polling only pays off when the I/O thread has a core to itself:
+ * pin it (ServerOptions::ioPlacement) away from the client on a machine
+ * with spare cores, or the spinning steals time from the client.
+ */
+
+#include "Router.hpp"
+#include "logging/Logger.hpp"
+#include "network/Server.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double p50 = 0;
+  double p99 = 0;
+  double p999 = 0;
+  double cpuPerRequest = 0; ///< Process CPU time, microseconds
+};
+
+double cpu_micros() {
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// One request on a new connection; false if the server did not answer
+bool round_trip(std::uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bool answered = false;
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == 0) {
+    static const char request[] = "GET /ping HTTP/1.1\r\nHost: bench\r\n\r\n";
+    if (::send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) > 0) {
+      char buffer[512];
+      // The server closes the connection after the response
+      while (::recv(fd, buffer, sizeof(buffer), 0) > 0)
+        answered = true;
+    }
+  }
+  ::close(fd);
+  return answered;
+}
+
+double percentile(std::vector<double> &sorted, double fraction) {
+  std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1));
+  return sorted[index];
+}
+
+Result measure(fion::Router &router, std::uint16_t port, std::size_t requests,
+               std::chrono::microseconds budget, std::chrono::microseconds gap) {
+  fion::network::ServerOptions options;
+  options.numThreads = 1;
+  options.workerThreads = 0;
+  options.busyPollBudget = budget;
+  fion::network::Server server(&router);
+  server.start("127.0.0.1", port, options);
+
+  // Warm up the connection path and the route
+  for (std::size_t i = 0; i < 200; ++i)
+    round_trip(port);
+
+  std::vector<double> latencies;
+  latencies.reserve(requests);
+  double cpuStart = cpu_micros();
+  for (std::size_t i = 0; i < requests; ++i) {
+    if (gap.count() > 0)
+      std::this_thread::sleep_for(gap);
+    auto start = Clock::now();
+    if (!round_trip(port))
+      continue;
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - start)
+            .count());
+  }
+  double cpu = cpu_micros() - cpuStart;
+  server.stop();
+
+  Result result;
+  if (latencies.empty())
+    return result;
+  std::sort(latencies.begin(), latencies.end());
+  result.p50 = percentile(latencies, 0.50);
+  result.p99 = percentile(latencies, 0.99);
+  result.p999 = percentile(latencies, 0.999);
+  result.cpuPerRequest = cpu / static_cast<double>(latencies.size());
+  return result;
+}
+
+void report(const char *mode, const Result &result) {
+  std::printf("%-22s %9.1f us %9.1f us %9.1f us %10.1f us\n", mode,
+              result.p50, result.p99, result.p999, result.cpuPerRequest);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t requests =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+  std::chrono::microseconds budget(argc > 2 ? std::atoll(argv[2]) : 50);
+  std::chrono::microseconds gap(argc > 3 ? std::atoll(argv[3]) : 0);
+  auto port =
+      static_cast<std::uint16_t>(argc > 4 ? std::atoi(argv[4]) : 18089);
+
+  fion::logging::Logger::set_level(fion::logging::LogLevel::Error);
+  fion::Router router;
+  router.addRoute(fion::Route(
+      "/ping", "GET",
+      fion::HandlerFunction([](std::unique_ptr<fion::http::Request>) {
+        auto response = std::make_unique<fion::http::Response>();
+        response->setBody("pong");
+        return response;
+      })));
+
+  std::printf("%zu requests, busy-poll budget %lld us, gap %lld us\n",
+              requests, static_cast<long long>(budget.count()),
+              static_cast<long long>(gap.count()));
+  std::printf("%-22s %12s %12s %12s %13s\n", "mode", "p50", "p99", "p99.9",
+              "cpu/request");
+  report("blocking", measure(router, port, requests,
+                             std::chrono::microseconds(0), gap));
+  report("busy polling", measure(router, port, requests, budget, gap));
+  return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Fork-join on the ThreadPool vs. the ad-hoc alternatives: one CPU-heavy
+ * call (a sum of square roots over a vector) run serially, split across
+ * freshly started std::threads, and split with parallel_for,
+ * parallel_reduce and submit + when_all. Several concurrent callers
+ * stand for concurrent requests: threads started per call oversubscribe
+ * the machine, the pool's workers do not.
+ *
+ * Usage: fork_join_benchmark [elements] [threads] [callers] [calls]
+ */
+
+#include "network/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+double sum_roots(const std::vector<double> &values, std::size_t begin,
+                 std::size_t end) {
+  double sum = 0;
+  for (std::size_t i = begin; i < end; ++i)
+    sum += std::sqrt(values[i]);
+  return sum;
+}
+
+// Runs calls from each of the callers at once; returns microseconds per call
+template <typename Fn>
+double micros_per_call(std::size_t callers, std::size_t calls, Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (std::size_t c = 0; c < callers; ++c)
+    threads.emplace_back([&] {
+      for (std::size_t i = 0; i < calls; ++i)
+        fn();
+    });
+  for (auto &thread : threads)
+    thread.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() /
+         static_cast<double>(callers * calls);
+}
+
+volatile double sink = 0;
+} // namespace
+
+int main(int argc, char **argv) {
+  using fion::network::ThreadPool;
+
+  std::size_t elements =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 20;
+  std::size_t threads =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+               : std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+  std::size_t callers = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4;
+  std::size_t calls = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 20;
+
+  std::vector<double> values(elements);
+  for (std::size_t i = 0; i < elements; ++i)
+    values[i] = static_cast<double>(i);
+  // About 16 chunks per worker, so idle workers can balance the load
+  std::size_t grain = std::max<std::size_t>(elements / (threads * 16), 1024);
+  ThreadPool pool(threads);
+
+  std::printf("%zu elements, %zu worker threads, %zu callers x %zu calls, "
+              "grain %zu\n",
+              elements, threads, callers, calls, grain);
+  std::printf("%-28s %12s\n", "scenario", "per call");
+
+  auto report = [&](const char *scenario, auto &&fn) {
+    std::printf("%-28s %9.1f us\n", scenario,
+                micros_per_call(callers, calls, fn));
+  };
+
+  report("serial", [&] { sink = sum_roots(values, 0, elements); });
+
+  report("std::thread per call", [&] {
+    std::vector<double> sums(threads);
+    std::vector<std::thread> spawned;
+    std::size_t share = (elements + threads - 1) / threads;
+    for (std::size_t t = 0; t < threads; ++t)
+      spawned.emplace_back([&, t] {
+        std::size_t begin = std::min(t * share, elements);
+        sums[t] = sum_roots(values, begin, std::min(begin + share, elements));
+      });
+    for (auto &thread : spawned)
+      thread.join();
+    double sum = 0;
+    for (double value : sums)
+      sum += value;
+    sink = sum;
+  });
+
+  report("parallel_for", [&] {
+    std::atomic<double> sum{0};
+    pool.parallel_for(0, elements, grain, [&](std::size_t b, std::size_t e) {
+      double part = sum_roots(values, b, e);
+      double current = sum.load(std::memory_order_relaxed);
+      while (!sum.compare_exchange_weak(current, current + part))
+        ;
+    });
+    sink = sum.load();
+  });
+
+  report("parallel_reduce", [&] {
+    sink = pool.parallel_reduce(
+        0, elements, grain, 0.0,
+        [&](std::size_t b, std::size_t e) { return sum_roots(values, b, e); },
+        [](double a, double b) { return a + b; });
+  });
+
+  report("submit + when_all", [&] {
+    std::vector<std::future<double>> parts;
+    for (std::size_t b = 0; b < elements; b += grain)
+      parts.push_back(pool.submit([&values, b, grain, elements] {
+        return sum_roots(values, b, std::min(b + grain, elements));
+      }));
+    double sum = 0;
+    for (double value : pool.when_all(parts))
+      sum += value;
+    sink = sum;
+  });
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Regex route matching: std::regex built per request (the old Router
+ * behaviour) vs. compiled once vs. the PatternMatcher linear scan.
+ *
+ * Usage: regex_routes_benchmark [iterations]
+ */
+
+#include "PatternMatcher.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+struct Case {
+  const char *pattern;
+  const char *path;
+};
+
+const std::vector<Case> kCases = {
+    {"/users/(\\d+)", "/users/123456"},
+    {"/users/(\\d+)/posts/([^/]+)", "/users/42/posts/hello-world"},
+    {"/search/(.*)", "/search/a/b/c/d/e/f"},
+    {"/assets/(.*)", "/assets/js/app.min.js"},
+};
+
+// Keeps the optimizer from dropping the loops
+volatile std::size_t sink = 0;
+
+template <typename Fn> double nanos_per_op(std::size_t iterations, Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    sink = sink + fn();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(iterations);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                    : 200000;
+
+  std::printf("%-32s %14s %14s %14s %9s\n", "pattern", "regex/request",
+              "regex/once", "fast path", "speedup");
+  for (const auto &c : kCases) {
+    std::string path = c.path;
+    std::size_t perRequestIterations = iterations / 20 + 1;
+
+    double perRequest = nanos_per_op(perRequestIterations, [&] {
+      std::smatch match;
+      std::regex re(c.pattern);
+      return static_cast<std::size_t>(std::regex_match(path, match, re));
+    });
+
+    fion::PatternMatcher regexOnly(c.pattern, false);
+    double once = nanos_per_op(iterations, [&] {
+      fion::RouteParams params;
+      return static_cast<std::size_t>(regexOnly.match(path, params));
+    });
+
+    fion::PatternMatcher fast(c.pattern);
+    if (!fast.is_fast()) {
+      std::fprintf(stderr, "%s does not take the fast path\n", c.pattern);
+      return 1;
+    }
+    double scan = nanos_per_op(iterations, [&] {
+      fion::RouteParams params;
+      return static_cast<std::size_t>(fast.match(path, params));
+    });
+
+    std::printf("%-32s %11.1f ns %11.1f ns %11.1f ns %8.1fx\n", c.pattern,
+                perRequest, once, scan, once / scan);
+  }
+  return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Router lookups on REST-shaped tables of 10 to 10,000 routes: latency,
+ * heap allocations per lookup and throughput of findRoute() and match()
+ * for hits, misses and the worst case (a miss scanning every regex route),
+ * plus match() throughput as threads are added and the time to register
+ * each table. Results are JSON.
+ *
+ * Usage: router_benchmark [--iterations N] [--threads N] [--output FILE]
+ */
+
+#include "Router.hpp"
+#include "logging/Logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Heap allocations made by the calling thread, counted by operator new
+thread_local std::size_t allocations = 0;
+
+// Keeps the optimizer from dropping the loops
+std::atomic<std::size_t> sink{0};
+
+struct NullHandler : fion::Handler {
+  std::unique_ptr<fion::http::Response>
+  handle(std::unique_ptr<fion::http::Request>) override {
+    return nullptr;
+  }
+};
+
+struct Table {
+  fion::Router router;
+  std::size_t resources = 0;
+  std::size_t regexRoutes = 0;
+};
+
+// Per resource: the five addResource() routes, a nested parameter route
+// for every 4th one and a regex route for every 10th one
+void add_routes(Table &table, std::size_t routeCount) {
+  auto handler = std::make_shared<NullHandler>();
+  std::size_t routes = 0;
+  for (std::size_t i = 0; routes < routeCount; ++i) {
+    std::string name = "res" + std::to_string(i);
+    table.router.addResource(name, handler);
+    routes += 5;
+    if (i % 4 == 0 && routes < routeCount) {
+      table.router.addRoute(fion::Route("/" + name + "/:id/items/:item",
+                                        "GET", handler));
+      ++routes;
+    }
+    if (i % 10 == 0 && routes < routeCount) {
+      table.router.addRoute(fion::Route("/" + name + "/files/(.*)", "GET",
+                                        handler, {}, true, {"path"}));
+      ++routes;
+      ++table.regexRoutes;
+    }
+    table.resources = i + 1;
+  }
+}
+
+// Milliseconds to register the routes and build the table, as an
+// application does before the server starts
+double build_table(Table &table, std::size_t routeCount) {
+  auto start = std::chrono::steady_clock::now();
+  add_routes(table, routeCount);
+  table.router.commit();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+struct Scenario {
+  const char *name;
+  std::vector<std::string> paths;
+};
+
+std::vector<Scenario> make_scenarios(const Table &table) {
+  const std::size_t n = table.resources;
+  auto resource = [n](std::size_t i) {
+    return "/res" + std::to_string((i * 7919) % n);
+  };
+  std::vector<Scenario> scenarios = {
+      {"hit_literal", {}}, {"hit_param", {}}, {"hit_nested", {}},
+      {"hit_regex", {}},   {"miss", {}},      {"worst_case", {}}};
+  for (std::size_t i = 0; i < 256; ++i) {
+    scenarios[0].paths.push_back(resource(i));
+    scenarios[1].paths.push_back(resource(i) + "/" + std::to_string(i));
+    std::size_t nested = ((i * 7919) % ((n + 3) / 4)) * 4;
+    scenarios[2].paths.push_back("/res" + std::to_string(nested) + "/" +
+                                 std::to_string(i) + "/items/" +
+                                 std::to_string(i * 3));
+    std::size_t regex = ((i * 7919) % ((n + 9) / 10)) * 10;
+    scenarios[3].paths.push_back("/res" + std::to_string(regex) +
+                                 "/files/docs/" + std::to_string(i) + ".txt");
+    scenarios[4].paths.push_back("/unknown/" + std::to_string(i));
+    // Walks into the tree, then falls through every regex route
+    scenarios[5].paths.push_back(resource(i) + "/" + std::to_string(i) +
+                                 "/nothing/here");
+  }
+  return scenarios;
+}
+
+struct Result {
+  double nsPerOp = 0;
+  double opsPerSec = 0;
+  double allocationsPerOp = 0;
+  std::size_t matched = 0;
+};
+
+template <typename Fn>
+Result measure(const std::vector<std::string> &paths, std::size_t iterations,
+               Fn &&lookup) {
+  // Warm up, then count only the timed loop
+  for (const auto &path : paths)
+    lookup(path);
+  std::size_t before = allocations;
+  std::size_t matched = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    matched += lookup(paths[i % paths.size()]);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::size_t allocated = allocations - before;
+  sink += matched;
+
+  Result result;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  result.nsPerOp = ns / static_cast<double>(iterations);
+  result.opsPerSec = 1e9 / result.nsPerOp;
+  result.allocationsPerOp =
+      static_cast<double>(allocated) / static_cast<double>(iterations);
+  result.matched = matched;
+  return result;
+}
+
+double scaling_ops_per_sec(const Table &table,
+                           const std::vector<std::string> &paths,
+                           std::size_t threadCount, std::size_t iterations) {
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&, t] {
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      std::size_t matched = 0;
+      for (std::size_t i = 0; i < iterations; ++i) {
+        fion::Router::RouteMatch match;
+        matched += table.router.match(fion::http::Method::GET,
+                                      paths[(i + t * 31) % paths.size()],
+                                      match);
+      }
+      sink += matched;
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &thread : threads)
+    thread.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  return static_cast<double>(iterations * threadCount) / seconds;
+}
+
+void print_result(std::FILE *out, const char *api, const Result &r,
+                  bool last) {
+  std::fprintf(out,
+               "          \"%s\": {\"ns_per_op\": %.1f, \"ops_per_sec\": %.0f, "
+               "\"allocations_per_op\": %.3f, \"matched\": %zu}%s\n",
+               api, r.nsPerOp, r.opsPerSec, r.allocationsPerOp, r.matched,
+               last ? "" : ",");
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+int main(int argc, char **argv) {
+  std::size_t iterations = 200000;
+  std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  const char *outputPath = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--iterations") == 0)
+      iterations = std::strtoull(argv[i + 1], nullptr, 10);
+    else if (std::strcmp(argv[i], "--threads") == 0)
+      maxThreads = std::strtoull(argv[i + 1], nullptr, 10);
+    else if (std::strcmp(argv[i], "--output") == 0)
+      outputPath = argv[i + 1];
+  }
+
+  // Debug logging would dominate findRoute(); its messages are still built
+  fion::logging::Logger::set_level(fion::logging::LogLevel::Warning);
+
+  std::FILE *out = outputPath ? std::fopen(outputPath, "w") : stdout;
+  if (out == nullptr) {
+    std::perror(outputPath);
+    return 1;
+  }
+
+  std::fprintf(out, "{\n  \"benchmark\": \"router\",\n");
+  std::fprintf(out, "  \"iterations\": %zu,\n  \"tables\": [\n", iterations);
+  const std::size_t sizes[] = {10, 100, 1000, 10000};
+  for (std::size_t s = 0; s < std::size(sizes); ++s) {
+    Table table;
+    double buildMs = build_table(table, sizes[s]);
+    std::fprintf(out,
+                 "    {\n      \"routes\": %zu,\n      \"regex_routes\": %zu,\n"
+                 "      \"build_ms\": %.1f,\n",
+                 table.router.getRoutes().size(), table.regexRoutes, buildMs);
+    std::fprintf(out, "      \"scenarios\": {\n");
+
+    auto scenarios = make_scenarios(table);
+    for (std::size_t c = 0; c < scenarios.size(); ++c) {
+      const auto &paths = scenarios[c].paths;
+      Result legacy = measure(paths, iterations / 4, [&](const std::string &p) {
+        std::map<std::string, std::string> params;
+        std::vector<std::function<void(std::unique_ptr<fion::http::Request> &)>>
+            middleware;
+        return table.router.findRoute(p, "GET", params, middleware) != nullptr;
+      });
+      Result fast = measure(paths, iterations, [&](const std::string &p) {
+        fion::Router::RouteMatch match;
+        return table.router.match(fion::http::Method::GET, p, match);
+      });
+      std::fprintf(out, "        \"%s\": {\n", scenarios[c].name);
+      print_result(out, "findRoute", legacy, false);
+      print_result(out, "match", fast, true);
+      std::fprintf(out, "        }%s\n", c + 1 < scenarios.size() ? "," : "");
+    }
+    std::fprintf(out, "      },\n      \"scaling\": [");
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      double ops = scaling_ops_per_sec(table, scenarios[1].paths, threads,
+                                       iterations);
+      std::fprintf(out, "%s{\"threads\": %zu, \"ops_per_sec\": %.0f}",
+                   threads > 1 ? ", " : "", threads, ops);
+    }
+    std::fprintf(out, "]\n    }%s\n", s + 1 < std::size(sizes) ? "," : "");
+  }
+  std::fprintf(out, "  ]\n}\n");
+  if (out != stdout)
+    std::fclose(out);
+  return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * ThreadPool throughput: the previous pool (one mutex, one condition
+ * variable, std::function tasks) vs. the work-stealing pool, for tasks
+ * submitted from outside, in batches and recursively from inside the pool.
+ *
+ * Run it on a machine with at least as many cores as worker threads plus
+ * producers. On fewer, the scheduler decides most of the result: with
+ * several producers sharing one core, both pools spend their time on the
+ * shared queue's lock, and the work-stealing pool additionally moves each
+ * task through a worker deque it cannot usefully be stolen from.
+ *
+ * Usage: thread_pool_benchmark [tasks] [threads]
+ */
+
+#include "network/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+// The pool as it was before work stealing, kept for comparison
+class LegacyThreadPool {
+private:
+  std::vector<std::thread> _threads;
+  std::queue<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _stop = false;
+
+  void worker_loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+        if (_stop && _tasks.empty())
+          return;
+        task = std::move(_tasks.front());
+        _tasks.pop();
+      }
+      task();
+    }
+  }
+
+public:
+  explicit LegacyThreadPool(std::size_t numThreads) {
+    for (std::size_t i = 0; i < numThreads; ++i)
+      _threads.emplace_back([this]() { worker_loop(); });
+  }
+
+  ~LegacyThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _cv.notify_all();
+    for (auto &thread : _threads)
+      thread.join();
+  }
+
+  template <typename F> void enqueue(F &&f) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _tasks.emplace(std::forward<F>(f));
+    }
+    _cv.notify_one();
+  }
+
+  // The old pool has no batch submission
+  template <typename F> void enqueue_batch(std::vector<F> &tasks) {
+    for (auto &task : tasks)
+      enqueue(std::move(task));
+    tasks.clear();
+  }
+};
+
+// Counts finished tasks; the main thread waits for the expected total
+struct Latch {
+  std::atomic<std::size_t> remaining;
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  explicit Latch(std::size_t count) : remaining(count) {}
+
+  void count_down() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      cv.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return remaining.load() == 0; });
+  }
+};
+
+// A little work per task, so the numbers are not only queue overhead
+volatile std::size_t sink = 0;
+void work() {
+  std::size_t value = 0;
+  for (std::size_t i = 0; i < 64; ++i)
+    value += i * i;
+  sink = sink + value;
+}
+
+template <typename Fn> double nanos_per_task(std::size_t tasks, Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(tasks);
+}
+
+template <typename Pool>
+double external(std::size_t threads, std::size_t tasks,
+                std::size_t producers) {
+  Pool pool(threads);
+  Latch latch(tasks);
+  return nanos_per_task(tasks, [&] {
+    std::vector<std::thread> submitters;
+    for (std::size_t p = 0; p < producers; ++p)
+      submitters.emplace_back([&, p] {
+        for (std::size_t i = p; i < tasks; i += producers)
+          pool.enqueue([&latch] {
+            work();
+            latch.count_down();
+          });
+      });
+    for (auto &submitter : submitters)
+      submitter.join();
+    latch.wait();
+  });
+}
+
+template <typename Pool, typename TaskType>
+double batched(std::size_t threads, std::size_t tasks) {
+  Pool pool(threads);
+  Latch latch(tasks);
+  return nanos_per_task(tasks, [&] {
+    constexpr std::size_t BATCH = 64;
+    std::vector<TaskType> batch;
+    for (std::size_t i = 0; i < tasks; i += BATCH) {
+      for (std::size_t j = i; j < tasks && j < i + BATCH; ++j)
+        batch.emplace_back([&latch] {
+          work();
+          latch.count_down();
+        });
+      pool.enqueue_batch(batch);
+    }
+    latch.wait();
+  });
+}
+
+// Each task spawns two children until the depth is reached
+template <typename Pool> struct Fork {
+  Pool &pool;
+  Latch &latch;
+
+  void operator()(std::size_t depth) const {
+    work();
+    if (depth > 0) {
+      Fork fork = *this;
+      pool.enqueue([fork, depth] { fork(depth - 1); });
+      pool.enqueue([fork, depth] { fork(depth - 1); });
+    }
+    latch.count_down();
+  }
+};
+
+template <typename Pool> double recursive(std::size_t threads, std::size_t tasks) {
+  std::size_t depth = 0;
+  while ((std::size_t{2} << (depth + 1)) - 1 <= tasks)
+    ++depth;
+  std::size_t total = (std::size_t{2} << depth) - 1;
+
+  Pool pool(threads);
+  Latch latch(total);
+  return nanos_per_task(total, [&] {
+    Fork<Pool> fork{pool, latch};
+    pool.enqueue([fork, depth] { fork(depth); });
+    latch.wait();
+  });
+}
+
+void report(const char *scenario, double legacy, double stealing) {
+  std::printf("%-28s %11.1f ns %11.1f ns %8.2fx\n", scenario, legacy, stealing,
+              legacy / stealing);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  using fion::network::Task;
+  using fion::network::ThreadPool;
+
+  std::size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  std::size_t threads =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+               : std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+
+  std::printf("%zu tasks, %zu worker threads\n", tasks, threads);
+  std::printf("%-28s %14s %14s %9s\n", "scenario", "legacy/task",
+              "stealing/task", "speedup");
+  report("external, 1 producer", external<LegacyThreadPool>(threads, tasks, 1),
+         external<ThreadPool>(threads, tasks, 1));
+  report("external, 4 producers",
+         external<LegacyThreadPool>(threads, tasks, 4),
+         external<ThreadPool>(threads, tasks, 4));
+  report("batches of 64",
+         batched<LegacyThreadPool, std::function<void()>>(threads, tasks),
+         batched<ThreadPool, Task>(threads, tasks));
+  report("recursive fan-out", recursive<LegacyThreadPool>(threads, tasks),
+         recursive<ThreadPool>(threads, tasks));
+  return 0;
+}
@@ -42,6 +42,67 @@ function(add_fion_example EXAMPLE_NAME)
     message(STATUS "Added example: ${EXAMPLE_NAME}")
 endfunction()
 
+# Function to create a benchmark executable
+#
+# Benchmarks are always built optimized and are not part of the test suite;
+# run them by hand and compare numbers on the same machine.
+function(add_fion_benchmark BENCHMARK_NAME)
+    cmake_parse_arguments(ARG "" "" "SOURCES;LIBRARIES" ${ARGN})
+
+    if(NOT ARG_SOURCES)
+        file(GLOB_RECURSE BENCHMARK_SOURCES "${CMAKE_CURRENT_SOURCE_DIR}/sources/*.cpp")
+    else()
+        set(BENCHMARK_SOURCES ${ARG_SOURCES})
+    endif()
+
+    add_executable(${BENCHMARK_NAME} ${BENCHMARK_SOURCES})
+    target_link_libraries(${BENCHMARK_NAME} PRIVATE fion)
+    if(ARG_LIBRARIES)
+        target_link_libraries(${BENCHMARK_NAME} PRIVATE ${ARG_LIBRARIES})
+    endif()
+    set_fion_target_properties(${BENCHMARK_NAME})
+    target_compile_options(${BENCHMARK_NAME} PRIVATE -O2)
+
+    if(EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/headers")
+        target_include_directories(${BENCHMARK_NAME} PRIVATE "${CMAKE_CURRENT_SOURCE_DIR}/headers")
+    endif()
+
+    message(STATUS "Added benchmark: ${BENCHMARK_NAME}")
+endfunction()
+
+# Function to pack a directory of static assets into an AssetBundle file
+#
+#   add_fion_asset_bundle(<target> DIRECTORY <dir> OUTPUT <file>)
+#
+# The pack is rebuilt whenever a file below DIRECTORY changes; add <target>
+# as a dependency of the executable that serves it.
+function(add_fion_asset_bundle BUNDLE_NAME)
+    cmake_parse_arguments(ARG "" "DIRECTORY;OUTPUT" "" ${ARGN})
+
+    if(NOT ARG_DIRECTORY OR NOT ARG_OUTPUT)
+        message(FATAL_ERROR "add_fion_asset_bundle: DIRECTORY and OUTPUT are required")
+    endif()
+    if(NOT TARGET fion_pack)
+        message(FATAL_ERROR "add_fion_asset_bundle: fion_pack is not built (enable BUILD_TOOLS)")
+    endif()
+
+    get_filename_component(BUNDLE_DIRECTORY "${ARG_DIRECTORY}" ABSOLUTE)
+    get_filename_component(BUNDLE_OUTPUT "${ARG_OUTPUT}" ABSOLUTE
+        BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+    file(GLOB_RECURSE BUNDLE_INPUTS CONFIGURE_DEPENDS "${BUNDLE_DIRECTORY}/*")
+
+    add_custom_command(
+        OUTPUT "${BUNDLE_OUTPUT}"
+        COMMAND fion_pack "${BUNDLE_DIRECTORY}" "${BUNDLE_OUTPUT}"
+        DEPENDS fion_pack ${BUNDLE_INPUTS}
+        COMMENT "Packing assets of ${BUNDLE_DIRECTORY}"
+        VERBATIM
+    )
+    add_custom_target(${BUNDLE_NAME} ALL DEPENDS "${BUNDLE_OUTPUT}")
+
+    message(STATUS "Added asset bundle: ${BUNDLE_NAME}")
+endfunction()
+
 # Function to set common target properties
 function(set_fion_target_properties TARGET_NAME)
     set_target_properties(${TARGET_NAME} PROPERTIES
@@ -0,0 +1,74 @@
+#include "Application.hpp"
+#include "StaticRoutes.hpp"
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+// Global application pointer for signal handling
+fion::Application *g_app = nullptr;
+
+// Signal handler for graceful shutdown
+void signal_handler(int signal) {
+  if (signal == SIGINT || signal == SIGTERM) {
+    std::cout << "\nShutting down server..." << std::endl;
+    if (g_app) {
+      g_app->stop();
+    }
+  }
+}
+
+// Handlers are plain types: the route table calls them without a vtable
+struct HelloHandler {
+  std::unique_ptr<fion::http::Response>
+  handle(std::unique_ptr<fion::http::Request> request) {
+    auto response = std::make_unique<fion::http::Response>();
+    response->setHeader("Content-Type", "text/plain");
+    response->setBody("Hello from a compile-time route table!");
+    return response;
+  }
+};
+
+struct UserHandler {
+  std::unique_ptr<fion::http::Response>
+  handle(std::unique_ptr<fion::http::Request> request) {
+    auto response = std::make_unique<fion::http::Response>();
+    try {
+      // Parsed in place from the path, without copying it
+      auto id = request->param<std::int64_t>("id");
+      response->setHeader("Content-Type", "application/json");
+      response->setBody("{\"id\": " + std::to_string(id) + "}");
+    } catch (const std::exception &) {
+      response->setStatusCode(fion::http::StatusCode::BAD_REQUEST);
+      response->setBody("id must be a number");
+    }
+    return response;
+  }
+};
+
+// Middleware is a type too, constructed and called inline
+struct LogPath {
+  void operator()(std::unique_ptr<fion::http::Request> &request) const {
+    std::cout << "[Middleware] " << request->getURL().getPathToResource()
+              << std::endl;
+  }
+};
+
+using Routes = fion::RouteTable<
+    fion::Get<"/", HelloHandler>,
+    fion::Get<"/users/:id", UserHandler, fion::MiddlewareChain<LogPath>>>;
+
+int main() {
+  fion::Application app;
+  g_app = &app;
+
+  // Set up signal handlers
+  std::signal(SIGINT, signal_handler);
+  std::signal(SIGTERM, signal_handler);
+
+  app.useStaticRoutes<Routes>();
+
+  std::cout << "Starting Fion server on http://0.0.0.0:8080" << std::endl;
+  app.run("0.0.0.0", 8080, 2);
+  return 0;
+}
@@ -23,6 +23,24 @@ public:
                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {},
                 bool isRegex = false,
                 const std::vector<std::string> &paramKeys = {});
+  // Same, with a callable stored inline instead of a Handler subclass
+  void addRoute(const std::string &pattern, const std::string &method,
+                HandlerFunction handler,
+                const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {},
+                bool isRegex = false,
+                const std::vector<std::string> &paramKeys = {});
+
+  // A fully described route, e.g. one with ExecutionMode::OFFLOAD
+  void addRoute(const Route &route);
+
+  // Global middleware and hooks, applied to every route (see Router)
+  void use(Middleware middleware);
+  void useInterceptor(Interceptor interceptor);
+  void useAfter(ResponseHook hook);
+
+  // Safe while the server runs (see Router)
+  bool removeRoute(const std::string &pattern, const std::string &method);
+  void replaceRoutes(const std::vector<Route> &routes);
 
   void addGroup(const std::string &prefix, const std::vector<Route> &groupRoutes,
                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &groupMiddleware = {});
@@ -31,11 +49,27 @@ public:
                    std::shared_ptr<Handler> handler,
                    const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
 
+  void addStatic(const std::string &prefix, const std::string &directory,
+                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
+
+  void addBundle(const std::string &prefix, const std::string &bundlePath,
+                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
+
+  // Dispatch through a compile-time RouteTable instead of the runtime
+  // router; routes added with addRoute() and friends are then ignored
+  template <typename Table> void useStaticRoutes() {
+    server = std::make_unique<network::Server>(&Table::dispatch);
+  }
+
+  void run(const std::string &host, std::uint16_t port,
+           std::size_t numThreads = network::available_cpus());
   void run(const std::string &host, std::uint16_t port,
-           std::size_t numThreads = 4);
+           const network::ServerOptions &options);
   void stop();
 
   Router &getRouter() { return router; }
+  // For its counters (route cache, admission)
+  network::Server &getServer() { return *server; }
 };
 
 } // namespace fion
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief Content codings an asset can be stored with
+ */
+enum class AssetEncoding : std::uint16_t {
+  IDENTITY = 0, ///< Stored as-is
+  GZIP = 1,     ///< Precompressed with gzip
+  BROTLI = 2,   ///< Precompressed with Brotli
+};
+
+/**
+ * @brief One asset stored in a bundle
+ *
+ * Every view points into the bundle's memory mapping and stays valid as
+ * long as the bundle does.
+ */
+struct Asset {
+  std::string_view path;        ///< Path relative to the bundle root
+  std::string_view contentType; ///< Media type of the identity content
+  std::string_view data;        ///< Stored bytes
+  AssetEncoding encoding;       ///< Coding of data
+  std::uint64_t hash;           ///< FNV-1a hash of the identity content
+};
+
+/**
+ * @brief Read-only, memory-mapped pack of static assets
+ *
+ * A pack starts with a header, followed by an index of fixed-size records
+ * sorted by path and encoding, a string table and the asset data. Opening a
+ * pack maps it and checks the header only, so startup does not depend on the
+ * number of assets; lookups binary-search the index in place. Replicas on
+ * one host share the mapped pages through the page cache.
+ *
+ * Packs are written with write() (see the fion_pack tool) and use the byte
+ * order of the machine that wrote them.
+ */
+class AssetBundle {
+public:
+  /**
+   * @brief Input of write(): one file, possibly with precompressed variants
+   */
+  struct Source {
+    std::string path;        ///< Path relative to the bundle root
+    std::string contentType; ///< Media type of the identity content
+    std::string content;     ///< Identity content
+    std::optional<std::string> gzip;   ///< gzip variant, if any
+    std::optional<std::string> brotli; ///< Brotli variant, if any
+  };
+
+private:
+  const char *_data;
+  std::size_t _size;
+  const char *_index; ///< First index record inside the mapping
+  std::uint32_t _entryCount;
+  std::string _path;
+
+  AssetBundle(const char *data, std::size_t size, std::string path);
+
+public:
+  /**
+   * @brief Unmap the pack
+   */
+  ~AssetBundle(void);
+
+  // Prevent copying (owns the mapping)
+  AssetBundle(const AssetBundle &) = delete;
+  AssetBundle &operator=(const AssetBundle &) = delete;
+
+  /**
+   * @brief Map a pack file
+   *
+   * @param path The pack file to open
+   * @return std::shared_ptr<const AssetBundle> The mapped bundle
+   * @throws std::runtime_error if the file cannot be mapped or is not a
+   * valid pack
+   */
+  static std::shared_ptr<const AssetBundle> open(const std::string &path);
+
+  /**
+   * @brief Write a pack file
+   *
+   * @param path The pack file to create
+   * @param sources The assets to store; order does not matter
+   * @throws std::runtime_error if the file cannot be written
+   * @throws std::invalid_argument if two sources share a path
+   */
+  static void write(const std::string &path, std::vector<Source> sources);
+
+  /**
+   * @brief Find an asset, preferring an encoding the client accepts
+   *
+   * @param path Path relative to the bundle root
+   * @param acceptEncoding Value of the request's Accept-Encoding header
+   * @return std::optional<Asset> The best variant, or std::nullopt if the
+   * path is not in the bundle
+   */
+  std::optional<Asset> find(std::string_view path,
+                            std::string_view acceptEncoding = {}) const;
+
+  /**
+   * @brief Get the number of stored variants
+   *
+   * @return std::size_t The number of index records
+   */
+  std::size_t size(void) const { return _entryCount; }
+
+  /**
+   * @brief Get the path the pack was mapped from
+   *
+   * @return const std::string& The pack file path
+   */
+  const std::string &path(void) const { return _path; }
+
+  /**
+   * @brief Hash bytes with 64-bit FNV-1a
+   *
+   * @param data The bytes to hash
+   * @return std::uint64_t The hash
+   */
+  static std::uint64_t hash(std::string_view data);
+};
+
+} // namespace fion
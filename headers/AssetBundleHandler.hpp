@@ -0,0 +1,52 @@
+#pragma once
+
+#include "AssetBundle.hpp"
+#include "Handler.hpp"
+
+#include <memory>
+#include <string>
+
+namespace fion {
+
+/**
+ * @brief Serves the assets of a memory-mapped bundle for a URL prefix
+ *
+ * Bodies are SharedBuffer views into the bundle mapping, so requests do no
+ * file I/O and copy nothing in user space. Precompressed variants are chosen
+ * from Accept-Encoding, ETags come from the content hashes stored in the
+ * bundle and If-None-Match is answered with 304 Not Modified.
+ *
+ * Register it with Router::addBundle().
+ */
+class AssetBundleHandler : public Handler {
+private:
+  std::string _prefix;
+  std::shared_ptr<const AssetBundle> _bundle;
+  std::string _indexFile;
+
+public:
+  /**
+   * @brief Construct a new Asset Bundle Handler object
+   *
+   * @param urlPrefix Request path prefix mapped to the bundle root
+   * @param bundle The mapped bundle to serve
+   * @param indexFile Asset served for directory paths
+   */
+  AssetBundleHandler(std::string urlPrefix,
+                     std::shared_ptr<const AssetBundle> bundle,
+                     std::string indexFile = "index.html");
+
+  std::unique_ptr<http::Response>
+  handle(std::unique_ptr<http::Request> request) override;
+
+  /**
+   * @brief Get the served bundle
+   *
+   * @return const std::shared_ptr<const AssetBundle>& The bundle
+   */
+  const std::shared_ptr<const AssetBundle> &bundle(void) const {
+    return _bundle;
+  }
+};
+
+} // namespace fion
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "AsyncTask.hpp"
+#include "Handler.hpp"
+#include "network/Async.hpp"
+
+#include <memory>
+
+namespace fion {
+
+// Handler written as a coroutine: handleAsync() may co_await timers,
+// socket readiness, offloaded work or body chunks (see network/Async.hpp)
+// without blocking the I/O thread. The Pool starts it on the connection's
+// event loop and writes the response once it finishes; it always resumes
+// on that loop's thread, so thousands of waiting requests cost a coroutine
+// frame each, not a thread.
+class AsyncHandler : public Handler {
+public:
+  virtual AsyncTask<std::unique_ptr<http::Response>>
+  handleAsync(std::unique_ptr<http::Request> request) = 0;
+
+  // The Handler contract, for callers outside an event loop: runs the
+  // coroutine on a private loop, blocking the calling thread
+  std::unique_ptr<http::Response>
+  handle(std::unique_ptr<http::Request> request) override {
+    return network::sync_wait(handleAsync(std::move(request)));
+  }
+};
+
+} // namespace fion
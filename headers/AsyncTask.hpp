@@ -0,0 +1,216 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace fion {
+
+template <typename T> class AsyncTask;
+
+/**
+ * @brief Owns detached tasks until they finish
+ *
+ * A task detached into a scope frees itself when it finishes, like any
+ * detached task. One still suspended when the scope is cancelled or
+ * destroyed is destroyed there instead, which runs the destructors of
+ * everything its frame holds. Use it for tasks whose awaitables may never
+ * resume them, such as those waiting on an event loop that stopped.
+ *
+ * Not thread-safe: start, finish and cancel its tasks on one thread.
+ */
+class TaskScope {
+private:
+  template <typename T> friend class AsyncTask;
+
+  std::unordered_set<void *> _frames; ///< Coroutine frame addresses
+
+public:
+  TaskScope(void) = default;
+  ~TaskScope(void) { cancel_all(); }
+
+  // Prevent copying (owns coroutine frames)
+  TaskScope(const TaskScope &) = delete;
+  TaskScope &operator=(const TaskScope &) = delete;
+
+  /**
+   * @brief Destroy every task of the scope that has not finished
+   *
+   * The tasks must not be resumed afterwards: whatever was going to resume
+   * them has to be stopped or discarded first.
+   */
+  void cancel_all(void) {
+    auto frames = std::exchange(_frames, {});
+    for (void *frame : frames)
+      std::coroutine_handle<>::from_address(frame).destroy();
+  }
+
+  /**
+   * @brief Get the number of tasks not finished yet
+   *
+   * @return std::size_t The number of suspended tasks
+   */
+  std::size_t size(void) const { return _frames.size(); }
+};
+
+/**
+ * @brief Lazily started coroutine producing a T
+ *
+ * The coroutine body starts running when the task is awaited, and the
+ * awaiting coroutine resumes right where the task finished, without going
+ * through a scheduler. Which thread that is depends on what the task
+ * awaited: the awaitables of network/Async.hpp always resume on the
+ * EventLoop thread the coroutine was suspended on.
+ *
+ * A task is awaited at most once. Exceptions thrown in the body are
+ * rethrown by co_await.
+ *
+ * @tparam T The result type, or void
+ */
+template <typename T = void> class [[nodiscard]] AsyncTask {
+public:
+  struct promise_type;
+
+private:
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    bool await_ready(void) const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+      promise_type &promise = handle.promise();
+      if (promise.continuation)
+        return promise.continuation;
+      // Nobody owns a detached task's frame but the task itself
+      if (promise.detached) {
+        if (promise.scope)
+          promise.scope->_frames.erase(handle.address());
+        handle.destroy();
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume(void) const noexcept {}
+  };
+
+  struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool detached = false;
+    TaskScope *scope = nullptr; ///< Of a detached task, if any
+
+    std::suspend_always initial_suspend(void) noexcept { return {}; }
+    FinalAwaiter final_suspend(void) noexcept { return {}; }
+    void unhandled_exception(void) noexcept {
+      exception = std::current_exception();
+    }
+  };
+
+  struct ValuePromise : PromiseBase {
+    std::optional<T> value;
+
+    template <typename U> void return_value(U &&result) {
+      value.emplace(std::forward<U>(result));
+    }
+  };
+
+  struct VoidPromise : PromiseBase {
+    void return_void(void) noexcept {}
+  };
+
+  Handle _handle;
+
+  explicit AsyncTask(Handle handle) : _handle(handle) {}
+
+public:
+  struct promise_type
+      : std::conditional_t<std::is_void_v<T>, VoidPromise, ValuePromise> {
+    AsyncTask get_return_object(void) {
+      return AsyncTask(Handle::from_promise(*this));
+    }
+  };
+
+  /**
+   * @brief Awaiter returned by co_await on a task
+   */
+  struct Awaiter {
+    Handle handle;
+
+    bool await_ready(void) const noexcept { return handle.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    T await_resume(void) {
+      promise_type &promise = handle.promise();
+      if (promise.exception)
+        std::rethrow_exception(promise.exception);
+      if constexpr (!std::is_void_v<T>)
+        return std::move(*promise.value);
+    }
+  };
+
+  AsyncTask(AsyncTask &&other) noexcept
+      : _handle(std::exchange(other._handle, nullptr)) {}
+
+  AsyncTask &operator=(AsyncTask &&other) noexcept {
+    if (this != &other) {
+      if (_handle)
+        _handle.destroy();
+      _handle = std::exchange(other._handle, nullptr);
+    }
+    return *this;
+  }
+
+  // Prevent copying (the task owns the coroutine frame)
+  AsyncTask(const AsyncTask &) = delete;
+  AsyncTask &operator=(const AsyncTask &) = delete;
+
+  ~AsyncTask(void) {
+    if (_handle)
+      _handle.destroy();
+  }
+
+  /**
+   * @brief Run the coroutine, then wait for its result
+   *
+   * @return Awaiter Resumes the caller with the result, or rethrows
+   */
+  Awaiter operator co_await() && noexcept { return Awaiter{_handle}; }
+
+  /**
+   * @brief Start the coroutine without waiting for it
+   *
+   * It runs until its first suspension before this returns, and frees
+   * itself once it finishes. Its result and exceptions are dropped, so the
+   * body should handle its own errors.
+   */
+  void detach(void) && {
+    Handle handle = std::exchange(_handle, nullptr);
+    handle.promise().detached = true;
+    handle.resume();
+  }
+
+  /**
+   * @brief Start the coroutine without waiting for it, owned by a scope
+   *
+   * Like detach(), but the scope destroys the coroutine if it is still
+   * suspended when the scope is cancelled.
+   *
+   * @param scope The scope; must outlive the task or cancel it
+   */
+  void detach(TaskScope &scope) && {
+    Handle handle = std::exchange(_handle, nullptr);
+    handle.promise().detached = true;
+    handle.promise().scope = &scope;
+    scope._frames.insert(handle.address());
+    handle.resume();
+  }
+};
+
+} // namespace fion
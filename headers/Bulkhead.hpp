@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace fion {
+
+/**
+ * @brief Cap on the requests of one route running at the same time
+ *
+ * Keeps a slow route from tying up every worker and connection: once
+ * @ref limit requests of the route are in flight, further ones are
+ * rejected right away instead of queueing behind them. Shared by every
+ * snapshot of the route table, so the count survives route updates.
+ */
+class Bulkhead {
+private:
+  const std::size_t _limit;
+  std::atomic<std::size_t> _inFlight{0};
+  std::atomic<std::uint64_t> _rejected{0};
+
+public:
+  /**
+   * @brief Slot held by an admitted request; frees it when destroyed
+   */
+  class Permit {
+  private:
+    std::shared_ptr<Bulkhead> _owner;
+
+  public:
+    Permit(void) = default;
+    explicit Permit(std::shared_ptr<Bulkhead> owner)
+        : _owner(std::move(owner)) {}
+    ~Permit(void) { release(); }
+
+    // Prevent copying (one slot per request)
+    Permit(const Permit &) = delete;
+    Permit &operator=(const Permit &) = delete;
+
+    Permit(Permit &&other) noexcept = default;
+    Permit &operator=(Permit &&other) noexcept {
+      if (this != &other) {
+        release();
+        _owner = std::move(other._owner);
+      }
+      return *this;
+    }
+
+    void release(void) {
+      if (_owner)
+        std::exchange(_owner, nullptr)
+            ->_inFlight.fetch_sub(1, std::memory_order_release);
+    }
+  };
+
+  /**
+   * @brief Construct a new Bulkhead object
+   *
+   * @param limit Maximum number of requests in flight
+   */
+  explicit Bulkhead(std::size_t limit) : _limit(limit) {}
+
+  // Prevent copying (shared through a pointer)
+  Bulkhead(const Bulkhead &) = delete;
+  Bulkhead &operator=(const Bulkhead &) = delete;
+
+  /**
+   * @brief Take a slot if one is free
+   *
+   * @param self The bulkhead; the permit keeps it alive
+   * @param permit Receives the slot
+   * @return true if admitted, false if the route is at its limit
+   */
+  static bool try_acquire(const std::shared_ptr<Bulkhead> &self,
+                          Permit &permit) {
+    if (self->_inFlight.fetch_add(1, std::memory_order_acquire) >=
+        self->_limit) {
+      self->_inFlight.fetch_sub(1, std::memory_order_relaxed);
+      self->_rejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    permit = Permit(self);
+    return true;
+  }
+
+  std::size_t limit(void) const { return _limit; }
+
+  std::size_t in_flight(void) const {
+    return _inFlight.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t rejected(void) const {
+    return _rejected.load(std::memory_order_relaxed);
+  }
+};
+
+} // namespace fion
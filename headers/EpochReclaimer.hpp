@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief Epoch-based reclamation for read-mostly shared data
+ *
+ * Readers pin the current epoch for as long as they use objects loaded
+ * from an atomic pointer; pinning is two atomic stores on a per-thread
+ * record and never blocks. Writers publish a replacement, then retire the
+ * old object, which is destroyed once every reader that could still see it
+ * has unpinned.
+ *
+ * There is one process-wide domain; guards nest, so a thread may pin
+ * while already pinned. A guard that must outlive the call that pinned,
+ * such as one held by a request handled on another thread, is detached:
+ * it then pins a record of its own, so the thread's record still returns
+ * to idle between calls.
+ */
+class EpochReclaimer {
+public:
+  /**
+   * @brief Reader state of a thread or a detached guard
+   *
+   * Records are never freed before the domain; released ones are reused.
+   *
+   * Cache-line aligned so pinning on one thread never invalidates the line
+   * another thread pins on.
+   */
+  struct alignas(64) ThreadRecord {
+    std::atomic<std::uint64_t> epoch{0}; ///< Pinned epoch, 0 when idle
+    std::size_t nesting = 0;             ///< Only touched by the owner
+    ThreadRecord *next = nullptr;        ///< Immutable once published
+  };
+
+  /**
+   * @brief Keeps the calling thread's epoch pinned while alive
+   */
+  class Guard {
+  private:
+    friend class EpochReclaimer;
+
+    ThreadRecord *_record = nullptr;
+    bool _detached = false; ///< Owns _record instead of nesting on it
+
+  public:
+    Guard(void) = default;
+    explicit Guard(ThreadRecord *record, bool detached = false)
+        : _record(record), _detached(detached) {}
+    ~Guard(void) { reset(); }
+
+    // Prevent copying (a pin is released exactly once)
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+    Guard(Guard &&other) noexcept
+        : _record(other._record), _detached(other._detached) {
+      other._record = nullptr;
+    }
+    Guard &operator=(Guard &&other) noexcept {
+      if (this != &other) {
+        reset();
+        _record = other._record;
+        _detached = other._detached;
+        other._record = nullptr;
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Release the pin early
+     */
+    void reset(void);
+
+    /**
+     * @brief Check whether the guard holds a pin
+     *
+     * @return true if the guard is active
+     */
+    explicit operator bool(void) const { return _record != nullptr; }
+  };
+
+private:
+  struct Retired {
+    std::uint64_t epoch;
+    std::function<void()> deleter;
+  };
+
+  std::atomic<std::uint64_t> _epoch{1};
+  std::atomic<ThreadRecord *> _records{nullptr};
+  std::mutex _freeMutex;              // Guards _free
+  std::vector<ThreadRecord *> _free; ///< Released records, reused first
+  std::mutex _retiredMutex;
+  std::vector<Retired> _retired;
+
+  EpochReclaimer(void) = default;
+
+  ThreadRecord *acquire_record(void);
+  void release_record(ThreadRecord *record);
+  std::uint64_t oldest_pinned_epoch(void) const;
+
+public:
+  /**
+   * @brief Destroy every object still retired
+   */
+  ~EpochReclaimer(void);
+
+  // Prevent copying (process-wide singleton)
+  EpochReclaimer(const EpochReclaimer &) = delete;
+  EpochReclaimer &operator=(const EpochReclaimer &) = delete;
+
+  /**
+   * @brief Get the process-wide domain
+   *
+   * @return EpochReclaimer& The domain
+   */
+  static EpochReclaimer &instance(void);
+
+  /**
+   * @brief Pin the current epoch on the calling thread
+   *
+   * @return Guard The pin; objects loaded while it is alive stay valid
+   */
+  Guard pin(void);
+
+  /**
+   * @brief Move a pin off the calling thread's record
+   *
+   * The returned guard keeps the same epoch pinned on a record of its own,
+   * so it may be held across calls and released from any thread, while
+   * the thread's record is unpinned as soon as its other guards are gone.
+   * Long-lived guards pinned on a shared thread record would overlap and
+   * keep it pinned at the oldest epoch, stalling reclamation.
+   *
+   * @param guard A guard from pin() on this thread, or an already detached
+   * or empty one, returned as is
+   * @return Guard The detached pin
+   */
+  Guard detach(Guard guard);
+
+  /**
+   * @brief Destroy an object once no reader can reference it anymore
+   *
+   * Must be called after the object was unpublished. Also destroys
+   * earlier retired objects that became unreachable.
+   *
+   * @param deleter Destroys the object
+   */
+  void retire(std::function<void()> deleter);
+
+  /**
+   * @brief Destroy retired objects that no reader can reference
+   *
+   * @return std::size_t The number of objects destroyed
+   */
+  std::size_t reclaim(void);
+
+  /**
+   * @brief Get the number of retired objects not destroyed yet
+   *
+   * @return std::size_t The number of pending objects
+   */
+  std::size_t pending(void);
+};
+
+} // namespace fion
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "InlineFunction.hpp"
 #include "http/Request.hpp"
 #include "http/Response.hpp"
 #include <memory>
@@ -13,4 +14,43 @@ public:
   handle(std::unique_ptr<http::Request> request) = 0;
 };
 
+// Optional contract for handlers that fill a response instead of allocating
+// one: the Pool lends a Request/Response pair it recycles between requests,
+// keeping their buffers. Neither may be kept after serve() returns.
+class PooledHandler : public Handler {
+public:
+  virtual void serve(http::Request &request, http::Response &response) = 0;
+
+  // The Handler contract, for callers that own the request
+  std::unique_ptr<http::Response>
+  handle(std::unique_ptr<http::Request> request) override {
+    auto response = std::make_unique<http::Response>();
+    serve(*request, *response);
+    return response;
+  }
+};
+
+// Handler given as a callable (typically a lambda) stored inline, without a
+// Handler subclass or heap allocation; it may be called concurrently
+using HandlerFunction =
+    InlineFunction<std::unique_ptr<http::Response>(std::unique_ptr<http::Request>)>;
+
+// Handler interface over a HandlerFunction, for code that needs a Handler
+class FunctionHandler : public Handler {
+private:
+  HandlerFunction _function;
+
+public:
+  explicit FunctionHandler(HandlerFunction function) : _function(std::move(function)) {}
+  std::unique_ptr<http::Response>
+  handle(std::unique_ptr<http::Request> request) override {
+    return _function(std::move(request));
+  }
+};
+
+// Statically dispatched alternative to Router (see RouteTable): returns
+// nullptr when no route matches
+using DispatchFunction =
+    std::unique_ptr<http::Response> (*)(std::unique_ptr<http::Request> request);
+
 } // namespace fion
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fion {
+
+template <typename Signature, std::size_t Capacity = 64> class InlineFunction;
+
+/**
+ * @brief Copyable callable stored inline, never on the heap
+ *
+ * Like std::function, but the callable must fit in @p Capacity bytes
+ * (checked at compile time) and is always called through a const
+ * reference, since one instance may serve several threads at once. Calls
+ * cost one indirect call and no reference counting.
+ *
+ * @tparam R Return type
+ * @tparam Args Argument types
+ * @tparam Capacity Bytes available for the callable
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+private:
+  struct Ops {
+    R (*invoke)(const void *callable, Args &&...args);
+    void (*copy)(void *destination, const void *source);
+    void (*move)(void *destination, void *source);
+    void (*destroy)(void *callable);
+  };
+
+  template <typename F> static constexpr Ops ops_for{
+      [](const void *callable, Args &&...args) -> R {
+        return std::invoke(*static_cast<const F *>(callable),
+                           std::forward<Args>(args)...);
+      },
+      [](void *destination, const void *source) {
+        ::new (destination) F(*static_cast<const F *>(source));
+      },
+      [](void *destination, void *source) {
+        ::new (destination) F(std::move(*static_cast<F *>(source)));
+      },
+      [](void *callable) { static_cast<F *>(callable)->~F(); }};
+
+  alignas(std::max_align_t) unsigned char _storage[Capacity];
+  const Ops *_ops = nullptr;
+
+public:
+  InlineFunction(void) = default;
+  InlineFunction(std::nullptr_t) {}
+
+  /**
+   * @brief Store a callable
+   *
+   * @tparam F A copyable type callable as R(Args...) through a const
+   * reference, at most Capacity bytes
+   * @param callable The callable
+   */
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, InlineFunction> &&
+             std::is_invocable_r_v<R, const std::decay_t<F> &, Args...>)
+  InlineFunction(F &&callable) {
+    using Stored = std::decay_t<F>;
+    static_assert(sizeof(Stored) <= Capacity,
+                  "Callable too large for InlineFunction; capture less or "
+                  "capture a pointer");
+    static_assert(alignof(Stored) <= alignof(std::max_align_t),
+                  "Callable over-aligned for InlineFunction");
+    static_assert(std::is_copy_constructible_v<Stored>,
+                  "InlineFunction callables must be copyable");
+    ::new (static_cast<void *>(_storage)) Stored(std::forward<F>(callable));
+    _ops = &ops_for<Stored>;
+  }
+
+  InlineFunction(const InlineFunction &other) : _ops(other._ops) {
+    if (_ops)
+      _ops->copy(_storage, other._storage);
+  }
+
+  InlineFunction(InlineFunction &&other) noexcept : _ops(other._ops) {
+    if (_ops)
+      _ops->move(_storage, other._storage);
+  }
+
+  InlineFunction &operator=(const InlineFunction &other) {
+    if (this != &other) {
+      InlineFunction copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  InlineFunction &operator=(InlineFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other._ops) {
+        other._ops->move(_storage, other._storage);
+        _ops = other._ops;
+      }
+    }
+    return *this;
+  }
+
+  ~InlineFunction(void) { reset(); }
+
+  /**
+   * @brief Destroy the stored callable, if any
+   */
+  void reset(void) {
+    if (_ops)
+      _ops->destroy(_storage);
+    _ops = nullptr;
+  }
+
+  /**
+   * @brief Check whether a callable is stored
+   *
+   * @return true if the function can be called
+   */
+  explicit operator bool(void) const { return _ops != nullptr; }
+
+  /**
+   * @brief Call the stored callable
+   *
+   * @param args The arguments
+   * @return R The callable's result
+   */
+  R operator()(Args... args) const {
+    return _ops->invoke(_storage, std::forward<Args>(args)...);
+  }
+};
+
+} // namespace fion
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "RouteTree.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief Compiled regex route pattern
+ *
+ * Patterns are compiled once, when the route is added. Patterns built only
+ * from literal characters and the groups people actually write for paths,
+ * (\d+), ([^/]+) and (.*), are matched by a single linear scan without
+ * std::regex; everything else falls back to a precompiled std::regex.
+ *
+ * The scan is only used when it cannot disagree with std::regex: a group
+ * must not be able to consume the character that follows it, and (.*) must
+ * end the pattern.
+ */
+class PatternMatcher {
+private:
+  enum class TokenKind : std::uint8_t {
+    LITERAL, ///< Exact bytes
+    DIGITS,  ///< (\d+)
+    SEGMENT, ///< ([^/]+)
+    REST,    ///< (.*)
+  };
+
+  struct Token {
+    TokenKind kind;
+    std::string literal; ///< Bytes to match for LITERAL tokens
+  };
+
+  std::string _pattern;
+  std::vector<Token> _tokens; ///< Empty when the fast path is not used
+  std::optional<std::regex> _regex;
+
+  bool parse(void);
+
+public:
+  /**
+   * @brief Compile a pattern
+   *
+   * @param pattern The ECMAScript regex matched against the whole path
+   * @param allowFastPath Set to false to always use std::regex
+   * @throws std::regex_error if the pattern needs std::regex and is invalid
+   */
+  explicit PatternMatcher(std::string pattern, bool allowFastPath = true);
+
+  /**
+   * @brief Match a whole path
+   *
+   * @param path The request path
+   * @param params Receives the capture groups, viewing @p path
+   * @return true if the path matches
+   */
+  bool match(std::string_view path, RouteParams &params) const;
+
+  /**
+   * @brief Check whether the linear matcher is used
+   *
+   * @return true if std::regex is never invoked for this pattern
+   */
+  bool is_fast(void) const { return !_regex.has_value(); }
+
+  /**
+   * @brief Get the source pattern
+   *
+   * @return const std::string& The pattern as registered
+   */
+  const std::string &pattern(void) const { return _pattern; }
+};
+
+} // namespace fion
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "AsyncTask.hpp"
+#include "Handler.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace fion {
+
+class AsyncHandler;
+
+/**
+ * @brief Middleware that inspects or rewrites the request
+ */
+using Middleware = std::function<void(std::unique_ptr<http::Request> &)>;
+
+/**
+ * @brief Middleware that may answer instead of the handler
+ *
+ * Returning a response ends the chain early (e.g. 401 from an auth check);
+ * returning nullptr continues with the next stage.
+ */
+using Interceptor = std::function<std::unique_ptr<http::Response>(
+    std::unique_ptr<http::Request> &)>;
+
+/**
+ * @brief Hook run on the response once the chain produced one
+ */
+using ResponseHook = std::function<void(http::Response &)>;
+
+/**
+ * @brief A route's middleware and handler composed into one callable
+ *
+ * Built once when the route table is published, then invoked by reference:
+ * running it copies no middleware, touches no reference count and
+ * allocates nothing itself. Stages run
+ * in order (global, group, then route middleware); hooks run on whatever
+ * response was produced, including early returns, innermost first.
+ */
+class Pipeline {
+public:
+  /**
+   * @brief One step before the handler; exactly one member is set
+   */
+  struct Stage {
+    Middleware middleware;
+    Interceptor interceptor;
+  };
+
+private:
+  std::unique_ptr<http::Response>
+  run_stages(std::unique_ptr<http::Request> &request) const;
+  void run_hooks(http::Response *response) const;
+
+  HandlerFunction _function; ///< Called directly when set
+  std::shared_ptr<Handler> _handler;
+  PooledHandler *_pooled = nullptr; ///< _handler, if it lends objects
+  AsyncHandler *_async = nullptr;   ///< _handler, if it is a coroutine
+  std::vector<Stage> _stages;
+  std::vector<ResponseHook> _hooks;
+
+public:
+  /**
+   * @brief Construct a new Pipeline object
+   *
+   * @param handler The route's handler
+   * @param function Called instead of the handler's handle() when set
+   * @param stages Steps run before the handler, in order
+   * @param hooks Hooks run on the response, in order
+   */
+  Pipeline(std::shared_ptr<Handler> handler, HandlerFunction function,
+           std::vector<Stage> stages, std::vector<ResponseHook> hooks);
+
+  /**
+   * @brief Run the stages, the handler and the hooks
+   *
+   * @param request The matched request
+   * @return std::unique_ptr<http::Response> The response, or nullptr if the
+   * handler returned none
+   */
+  std::unique_ptr<http::Response>
+  run(std::unique_ptr<http::Request> request) const;
+
+  /**
+   * @brief Run the pipeline on a borrowed request
+   *
+   * A PooledHandler fills @p spare (created if null) in place and leaves
+   * @p request with the caller; other handlers take the request and return
+   * their own response, leaving @p spare alone.
+   *
+   * @param request The matched request; reset if the handler took it
+   * @param spare A cleared response to lend to a PooledHandler
+   * @return std::unique_ptr<http::Response> The response, or nullptr if the
+   * handler returned none
+   */
+  std::unique_ptr<http::Response>
+  run(std::unique_ptr<http::Request> &request,
+      std::unique_ptr<http::Response> &spare) const;
+
+  /**
+   * @brief Run the pipeline with the handler as a coroutine
+   *
+   * Stages run before the coroutine starts and hooks once it finished.
+   * Only for pipelines whose handler is an AsyncHandler.
+   *
+   * @param request The matched request
+   * @return AsyncTask<std::unique_ptr<http::Response>> The response, or
+   * nullptr if the handler returned none
+   */
+  AsyncTask<std::unique_ptr<http::Response>>
+  run_async(std::unique_ptr<http::Request> request) const;
+
+  /**
+   * @brief Check whether the handler is an AsyncHandler
+   *
+   * @return true if the pipeline must be run with run_async()
+   */
+  bool is_async(void) const { return _async != nullptr; }
+
+  /**
+   * @brief Get the route's handler
+   *
+   * @return const std::shared_ptr<Handler>& The handler
+   */
+  const std::shared_ptr<Handler> &handler(void) const { return _handler; }
+
+  /**
+   * @brief Get the steps run before the handler
+   *
+   * @return const std::vector<Stage>& The stages, in order
+   */
+  const std::vector<Stage> &stages(void) const { return _stages; }
+};
+
+} // namespace fion
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Handler.hpp"
+#include "Pipeline.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -9,15 +11,27 @@
 
 namespace fion {
 
+// Where a route's middleware and handler run
+enum class ExecutionMode {
+  INLINE,  // On the I/O thread that read the request (cheap handlers)
+  OFFLOAD  // On the server's worker pool; the I/O thread keeps serving
+};
 
 class Route {
 public:
   std::string pathPattern; // e.g. /users/:id or regex
   std::string method;
   std::shared_ptr<Handler> handler;
+  HandlerFunction function; // Used instead of handler when set
   std::vector<std::function<void(std::unique_ptr<http::Request>&)>> middleware;
   bool isRegex = false;
   std::vector<std::string> paramKeys; // e.g. ["id"]
+  std::vector<Interceptor> interceptors; // Run after middleware, may answer early
+  std::vector<ResponseHook> responseHooks; // Run on the response, before global ones
+  ExecutionMode execution = ExecutionMode::INLINE;
+  // Bulkhead: requests of this route allowed in flight at once, across all
+  // threads; past it the server answers 503 (see ServerOptions). 0 for no cap
+  std::size_t maxInFlight = 0;
 
   Route() = default;
   Route(const std::string &pattern, const std::string &method,
@@ -25,6 +39,11 @@ public:
         const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {},
         bool isRegex = false,
         const std::vector<std::string> &paramKeys = {});
+  Route(const std::string &pattern, const std::string &method,
+        HandlerFunction function,
+        const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {},
+        bool isRegex = false,
+        const std::vector<std::string> &paramKeys = {});
 };
 
 } // namespace fion
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Router.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief Bounded cache of route matches for hot paths
+ *
+ * Maps (method, path) to the matched route and the positions of its
+ * parameters, so repeated requests for the same path skip matching. The
+ * cache is 4-way set associative with LRU replacement inside a set; entries
+ * are recycled in place, so a warm cache does not allocate.
+ *
+ * A cache belongs to a single thread (one per Pool) and takes no locks. It
+ * drops its entries when the router's version changes. Only matches of
+ * canonical paths are cached, and misses (404s) never are.
+ */
+class RouteCache {
+public:
+  /**
+   * @brief Hit and miss counters of a cache
+   */
+  struct Stats {
+    std::uint64_t hits = 0;   ///< Lookups answered from the cache
+    std::uint64_t misses = 0; ///< Lookups that went to the router
+    std::size_t entries = 0;  ///< Entries currently cached
+    std::size_t capacity = 0; ///< Maximum number of entries
+  };
+
+  /**
+   * @brief Longest path that is cached
+   */
+  static constexpr std::size_t MAX_CACHED_PATH = 1024;
+
+private:
+  static constexpr std::size_t WAYS = 4;
+
+  struct Entry {
+    std::uint64_t hash = 0;
+    std::uint64_t lastUsed = 0; ///< 0 for an empty slot
+    http::Method method = http::Method::GET;
+    std::string path;
+    const Router::RouteTarget *target = nullptr;
+    std::size_t paramCount = 0;
+    std::array<std::pair<std::uint16_t, std::uint16_t>, MAX_ROUTE_PARAMS>
+        params; ///< Offset and length of each value in the path
+  };
+
+  std::vector<Entry> _entries;
+  std::size_t _setMask = 0;
+  std::uint64_t _version = 0;
+  std::uint64_t _tick = 0;
+  // Written by the owning thread only; atomic so stats() can read them
+  std::atomic<std::size_t> _size{0};
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _misses{0};
+
+  void store(http::Method method, std::string_view path, std::uint64_t hash,
+             const Router::RouteMatch &match);
+
+public:
+  /**
+   * @brief Construct a new Route Cache object
+   *
+   * @param capacity Maximum number of entries, rounded up to a power of
+   * two; 0 disables the cache
+   */
+  explicit RouteCache(std::size_t capacity = 0);
+
+  // Prevent copying (owned by one thread)
+  RouteCache(const RouteCache &) = delete;
+  RouteCache &operator=(const RouteCache &) = delete;
+
+  /**
+   * @brief Match a request, from the cache when possible
+   *
+   * @param router The router to fall back to and to check the version of
+   * @param method The request method
+   * @param path The request path; parameter values view it
+   * @param out Receives the match
+   * @return true if a route matched
+   */
+  bool match(const Router &router, http::Method method, std::string_view path,
+             Router::RouteMatch &out);
+
+  /**
+   * @brief Reallocate the cache with a new capacity, dropping every entry
+   *
+   * Lets the owning thread allocate the entries itself (first touch puts
+   * them on its NUMA node).
+   *
+   * @param capacity Maximum number of entries, rounded up to a power of
+   * two; 0 disables the cache
+   */
+  void resize(std::size_t capacity);
+
+  /**
+   * @brief Drop every entry
+   */
+  void clear(void);
+
+  /**
+   * @brief Check whether the cache is enabled
+   *
+   * @return true if the capacity is not zero
+   */
+  bool enabled(void) const { return !_entries.empty(); }
+
+  /**
+   * @brief Get the counters; safe to call from any thread
+   *
+   * @return Stats The current counters
+   */
+  Stats stats(void) const;
+};
+
+} // namespace fion
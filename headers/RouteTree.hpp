@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief Most path parameters a single route can capture
+ */
+constexpr std::size_t MAX_ROUTE_PARAMS = 16;
+
+/**
+ * @brief Parameter values captured while matching a path
+ *
+ * The values view the matched path and are stored in place, so matching
+ * never allocates.
+ */
+struct RouteParams {
+  std::array<std::string_view, MAX_ROUTE_PARAMS> values; ///< In path order
+  std::size_t count = 0; ///< Number of captured values
+};
+
+/**
+ * @brief Compressed radix tree mapping path patterns to route indices
+ *
+ * Patterns are normalized paths whose segments are either literal or a
+ * ":name" parameter matching one non-empty segment. Literal edges are shared
+ * between patterns byte by byte and tried before parameters; matching
+ * backtracks when a literal branch dead-ends.
+ */
+class RouteTree {
+public:
+  /**
+   * @brief Index returned when no pattern matches
+   */
+  static constexpr std::uint32_t NO_ROUTE = UINT32_MAX;
+
+private:
+  struct Node {
+    std::string prefix;  ///< Literal bytes consumed by this edge
+    std::string indices; ///< First byte of each literal child
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param; ///< Child matching one ":name" segment
+    std::uint32_t route = NO_ROUTE;
+  };
+
+  Node _root;
+  std::size_t _size = 0;
+
+  static Node *insert_literal(Node *node, std::string_view bytes);
+  static std::uint32_t match_node(const Node &node, std::string_view rest,
+                                  RouteParams &params);
+
+public:
+  /**
+   * @brief Add a pattern
+   *
+   * @param pattern A normalized pattern (see normalize())
+   * @param route The index to return when the pattern matches
+   * @return true if added, false if the pattern was already present (the
+   * first registration is kept)
+   * @throws std::invalid_argument if the pattern has more than
+   * MAX_ROUTE_PARAMS parameters
+   */
+  bool insert(std::string_view pattern, std::uint32_t route);
+
+  /**
+   * @brief Match a path
+   *
+   * @param path A normalized request path
+   * @param params Receives the parameter values, viewing @p path
+   * @return std::uint32_t The route index, or NO_ROUTE
+   */
+  std::uint32_t match(std::string_view path, RouteParams &params) const;
+
+  /**
+   * @brief Get the number of patterns in the tree
+   *
+   * @return std::size_t The number of patterns
+   */
+  std::size_t size(void) const { return _size; }
+
+  /**
+   * @brief Check whether a path is already normalized
+   *
+   * @param path The path to check
+   * @return true if it starts with '/', has no empty segment and no
+   * trailing slash (except for "/")
+   */
+  static bool is_normalized(std::string_view path);
+
+  /**
+   * @brief Normalize a path or pattern
+   *
+   * Collapses repeated slashes, drops the trailing slash and makes the
+   * path absolute, so "/users//42/" becomes "/users/42".
+   *
+   * @param path The path to normalize
+   * @return std::string The normalized path
+   */
+  static std::string normalize(std::string_view path);
+
+  /**
+   * @brief Check whether a normalized pattern has no parameters
+   *
+   * @param pattern The pattern to check
+   * @return true if every segment is literal
+   */
+  static bool is_literal(std::string_view pattern);
+};
+
+} // namespace fion
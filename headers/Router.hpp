@@ -1,36 +1,216 @@
 #pragma once
 
 
+#include "Bulkhead.hpp"
+#include "EpochReclaimer.hpp"
 #include "Handler.hpp"
+#include "PatternMatcher.hpp"
+#include "Pipeline.hpp"
 #include "Route.hpp"
+#include "RouteTree.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <functional>
+#include <unordered_map>
 
 namespace fion {
 
 class Router {
 public:
-  std::vector<Route> routes;
+  // Data needed once a route matched, kept apart from the registration
+  // record so the dispatch path touches as little memory as possible
+  struct RouteTarget {
+    Pipeline pipeline; // Global, group and route middleware plus handler
+    std::vector<std::string> paramKeys; // Viewed by the requests it matched
+    ExecutionMode execution = ExecutionMode::INLINE;
+    std::shared_ptr<Bulkhead> bulkhead; // Null when the route has no cap
+  };
 
-  Router() = default;
+  // Result of match(); parameter values view the matched path (or the
+  // normalized copy held here), so keep the path alive while using them.
+  // The guard keeps the route table the target belongs to alive, even if
+  // routes are replaced meanwhile; release it once the handler returned.
+  struct RouteMatch {
+    const RouteTarget *target = nullptr;
+    RouteParams params;
+    std::string normalizedPath; // Only filled for non-canonical paths
+    EpochReclaimer::Guard guard;
 
+    explicit operator bool() const { return target != nullptr; }
+  };
+
+private:
+  static constexpr std::size_t METHOD_COUNT =
+      static_cast<std::size_t>(http::Method::PATCH) + 1;
+
+  // Hash functor allowing std::string_view lookups in the exact-path table
+  struct PathHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view path) const {
+      return std::hash<std::string_view>()(path);
+    }
+  };
+
+  // Per-method lookup structures, tried in this order
+  struct MethodTable {
+    std::unordered_map<std::string, std::uint32_t, PathHash, std::equal_to<>> exact;
+    RouteTree tree;
+    std::vector<std::pair<std::uint32_t, const PatternMatcher *>> regex; // In registration order
+  };
+
+  // Route as registered; the compiled regex is shared between snapshots
+  struct Registration {
+    Route route;
+    std::shared_ptr<const PatternMatcher> matcher;
+    std::shared_ptr<Bulkhead> bulkhead{}; // In-flight count kept across updates
+  };
+
+  // Everything a table is built from; writers edit a copy of it
+  struct Definition {
+    std::vector<Registration> routes;   // In registration order
+    std::vector<Pipeline::Stage> stages; // Global, in use() order
+    std::vector<ResponseHook> hooks;     // Global, in useAfter() order
+  };
+
+  // Immutable once published: writers build a new snapshot and swap it in
+  struct Snapshot {
+    Definition definition;           // Cold
+    std::deque<RouteTarget> targets; // Hot: same indices as definition.routes
+    std::array<MethodTable, METHOD_COUNT> tables;
+    std::uint64_t version = 0;
+  };
+
+  std::atomic<const Snapshot *> _current;
+  std::atomic<std::uint64_t> _version{0}; // Version of _current
+  std::recursive_mutex _writeMutex;        // Serializes writers only
+
+  // Changes not published yet; all but _unpublished guarded by _writeMutex
+  Definition _pending;      // Current definition plus the changes, while _staged
+  bool _staged = false;
+  bool _live = false;       // Set by commit(): publish every change at once
+  unsigned _batchDepth = 0; // Nesting of batch() calls
+  std::atomic<bool> _unpublished{false}; // Staged before commit(); the next
+                                         // lookup publishes them
+
+  static bool matchMethod(const Snapshot &snapshot, http::Method method,
+                          std::string_view path, std::string_view normalized,
+                          RouteMatch &out);
+
+  // Check a route and compile its regex, so that staged routes fail when
+  // registered rather than when published. Throws like addRoute().
+  static Registration prepare(Route route,
+                              std::shared_ptr<const PatternMatcher> matcher = nullptr);
+
+  // Let edit() change the pending definition (a copy of the current one
+  // unless changes are already staged) and publish the result unless
+  // edit() returns false. Before commit() and inside batch(), the change
+  // is only staged. Returns the number of duplicate routes dropped.
+  std::size_t update(const std::function<bool(Definition &)> &edit);
+  // Publish the staged changes at once if committed, otherwise leave them
+  // for commit() or the next lookup; _writeMutex held
+  std::size_t settle();
+  // Publish the staged changes, if any; _writeMutex held
+  std::size_t flush();
+  // Build a snapshot from a definition and swap it in; _writeMutex held
+  std::size_t publish(Definition definition);
+  // Publish what was staged before commit() so lookups see it
+  void publishStaged() const;
+
+public:
+  Router();
+  ~Router();
+
+  // Prevent copying (readers hold pointers into the current snapshot)
+  Router(const Router &) = delete;
+  Router &operator=(const Router &) = delete;
+
+  // Routes can be added, removed or replaced while the server runs: each
+  // change publishes a new immutable table and lookups never lock. Requests
+  // already matched finish on the table they matched against. Until
+  // commit(), changes are staged and the table is built once, by commit()
+  // or the first lookup, so registering N routes at startup costs O(N).
+
+  // Publish the staged changes; every later change is published at once.
+  // Server::start() calls it.
+  void commit();
+
+  // Throws std::invalid_argument for an unknown method or too many params,
+  // std::regex_error for an invalid regex pattern
   void addRoute(const Route &route);
 
-  // Find route and extract parameters
+  // Global middleware, run before group and route middleware of every
+  // route (including routes added earlier)
+  void use(Middleware middleware);
+  // Global middleware that may answer early instead of the handler
+  void useInterceptor(Interceptor interceptor);
+  // Global hook run on every routed response, after the route's own hooks
+  void useAfter(ResponseHook hook);
+
+  // Apply the changes made by calling this router's methods as one update:
+  // the table is rebuilt once instead of once per call, and other threads
+  // see all of the changes or none. Use it to change many routes of a
+  // running server. If changes() throws, none of them is kept.
+  void batch(const std::function<void()> &changes);
+
+  // Remove the route registered with this pattern and method; returns false
+  // if there is none
+  bool removeRoute(const std::string &pattern, const std::string &method);
+
+  // Replace every route at once, so no request sees a mix of both sets.
+  // Throws like addRoute(), leaving the current routes in place.
+  void replaceRoutes(const std::vector<Route> &routes);
+
+  // Routes in registration order (a copy of the current table)
+  std::vector<Route> getRoutes() const;
+
+  // Changes whenever the route table changes (see RouteCache)
+  std::uint64_t version() const {
+    if (_unpublished.load(std::memory_order_acquire))
+      publishStaged();
+    return _version.load();
+  }
+
+  // Find the route for a request without allocating (for canonical paths):
+  // exact literal paths first, then the radix tree, then regex routes.
+  // HEAD requests fall back to GET routes. Pins out.guard.
+  bool match(http::Method method, std::string_view path, RouteMatch &out) const;
+
+  // Find route and extract parameters. Legacy: copies the middleware and
+  // leaves out interceptors and hooks; prefer match() and the pipeline.
   std::shared_ptr<Handler> findRoute(const std::string &path,
                                      const std::string &method,
                                      std::map<std::string, std::string> &outParams,
                                      std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &outMiddleware);
 
-  // Grouping and RESTful helpers
+  // Grouping and RESTful helpers; group middleware runs before the
+  // routes' own middleware
   void addGroup(const std::string &prefix, const std::vector<Route> &groupRoutes,
                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &groupMiddleware = {});
   void addResource(const std::string &resource,
                    std::shared_ptr<Handler> handler,
                    const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
+
+  // Serve the files of a directory under a URL prefix (GET and HEAD)
+  void addStatic(const std::string &prefix, const std::string &directory,
+                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
+
+  // Serve a pack built by fion_pack under a URL prefix (GET and HEAD);
+  // throws std::runtime_error if the pack cannot be mapped
+  void addBundle(const std::string &prefix, const std::string &bundlePath,
+                 const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware = {});
+
+private:
+  // Register GET and HEAD regex routes for everything below a prefix
+  void addPrefixRoutes(const std::string &prefix, std::shared_ptr<Handler> handler,
+                       const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware);
 };
 
 } // namespace fion
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "Handler.hpp"
+#include "http/Body.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace fion {
+
+/**
+ * @brief Serves files below a directory for a URL prefix
+ *
+ * Files are sent with sendfile(2) through FileRegion bodies, so their
+ * content never passes through user space. Open descriptors, sizes and
+ * modification times are cached; past Options::maxCachedFiles, entries
+ * are evicted in CLOCK order, which keeps the files hit recently. On Linux
+ * the cache is invalidated through inotify by a thread that waits for its
+ * events, so hits make no system call; elsewhere each hit is revalidated
+ * with stat(2). Responses carry
+ * ETag and Last-Modified validators and honour If-None-Match and
+ * If-Modified-Since with 304 Not Modified.
+ *
+ * Register it with Router::addStatic(), or as a regular route whose
+ * pattern matches everything below the prefix.
+ */
+class StaticFileHandler : public Handler {
+public:
+  /**
+   * @brief Tuning knobs for the handler
+   */
+  struct Options {
+    std::string indexFile = "index.html"; ///< Served for directory paths
+    std::string cacheControl;     ///< Cache-Control value, unset if empty
+    std::size_t maxCachedFiles = 1024; ///< Open descriptors kept at most
+  };
+
+private:
+  /**
+   * @brief Cached metadata and open descriptor of one file
+   */
+  struct Entry {
+    std::shared_ptr<const http::FileHandle> file;
+    std::size_t size;
+    std::time_t mtime;
+    std::string etag;
+    std::string lastModified;
+    std::string contentType;
+  };
+
+  std::string _prefix;
+  std::string _root;
+  Options _options;
+  /**
+   * @brief A cached entry and its place on the eviction clock
+   */
+  struct Cached {
+    std::shared_ptr<const Entry> entry;
+    std::list<std::string>::iterator position; ///< In _clock
+    mutable std::atomic<bool> referenced{false}; ///< Hit since last passed
+  };
+
+  std::unordered_map<std::string, Cached> _cache;
+  std::list<std::string> _clock; ///< Cached paths, in insertion order
+  std::list<std::string>::iterator _hand; ///< Next eviction candidate
+  mutable std::shared_mutex _mutex;
+  int _inotifyFD;                                  ///< -1 when unavailable
+  int _stopFD = -1;     ///< Wakes the watcher to exit; -1 without inotify
+  std::thread _watcher; ///< Applies inotify events as they arrive
+  std::unordered_map<int, std::string> _watches;   ///< wd -> relative dir
+  std::unordered_map<std::string, int> _watchedDirs; ///< relative dir -> wd
+
+  /**
+   * @brief Drop a cached path; _mutex must be held exclusively
+   *
+   * @param relativePath The path, cached or not
+   */
+  void forget(const std::string &relativePath);
+
+  /**
+   * @brief Drop every cached path; _mutex must be held exclusively
+   */
+  void forget_all(void);
+
+  /**
+   * @brief Evict the first entry the clock hand finds not hit since it
+   * last passed; _mutex must be held exclusively
+   */
+  void evict_one(void);
+
+  /**
+   * @brief Apply pending inotify events to the cache
+   */
+  void drain_events();
+
+  /**
+   * @brief Watcher thread: drain events whenever the inotify descriptor
+   * is readable, until _stopFD is
+   */
+  void watch_loop();
+
+  /**
+   * @brief Watch the directory of a cached file for changes
+   *
+   * @param relativeDir Directory relative to the root ("" for the root)
+   */
+  void watch_directory(const std::string &relativeDir);
+
+  /**
+   * @brief Find or open the file behind a relative path
+   *
+   * @param relativePath Decoded path relative to the root
+   * @return std::shared_ptr<const Entry> The entry, or nullptr if missing
+   */
+  std::shared_ptr<const Entry> lookup(const std::string &relativePath);
+
+  /**
+   * @brief Open a file and build its cache entry
+   *
+   * @param relativePath Path relative to the root; updated to the index
+   * file when it names a directory
+   * @return std::shared_ptr<const Entry> The entry, or nullptr if missing
+   */
+  std::shared_ptr<const Entry> open_entry(std::string &relativePath) const;
+
+public:
+  /**
+   * @brief Construct a new Static File Handler object
+   *
+   * @param urlPrefix Request path prefix mapped to the directory (e.g.
+   * "/assets")
+   * @param rootDirectory Directory the files are served from
+   * @param options Handler options
+   */
+  StaticFileHandler(std::string urlPrefix, std::string rootDirectory,
+                    Options options);
+
+  /**
+   * @brief Construct a new Static File Handler object with default options
+   *
+   * @param urlPrefix Request path prefix mapped to the directory
+   * @param rootDirectory Directory the files are served from
+   */
+  StaticFileHandler(std::string urlPrefix, std::string rootDirectory)
+      : StaticFileHandler(std::move(urlPrefix), std::move(rootDirectory),
+                          Options()) {}
+
+  /**
+   * @brief Stop the watcher, close the inotify descriptor and every cached
+   * file
+   */
+  ~StaticFileHandler(void) override;
+
+  // Prevent copying (owns descriptors)
+  StaticFileHandler(const StaticFileHandler &) = delete;
+  StaticFileHandler &operator=(const StaticFileHandler &) = delete;
+
+  std::unique_ptr<http::Response>
+  handle(std::unique_ptr<http::Request> request) override;
+
+  /**
+   * @brief Drop every cached descriptor
+   */
+  void clear_cache(void);
+
+  /**
+   * @brief Get the number of cached files
+   *
+   * @return std::size_t The number of open descriptors kept
+   */
+  std::size_t cached_files(void) const;
+
+  /**
+   * @brief Guess a Content-Type from a file name extension
+   *
+   * @param path The file path
+   * @return std::string The media type, application/octet-stream if unknown
+   */
+  static std::string content_type_for(const std::string &path);
+
+  /**
+   * @brief Format a time as an HTTP date (IMF-fixdate)
+   *
+   * @param time The time to format
+   * @return std::string The formatted date
+   */
+  static std::string format_http_date(std::time_t time);
+
+  /**
+   * @brief Percent-decode a request path relative to a prefix
+   *
+   * Rejects "." and ".." segments, NUL bytes and backslashes so the result
+   * can never leave the served root; leading slashes are dropped.
+   *
+   * @param raw The encoded path below the prefix
+   * @param out Receives the decoded relative path
+   * @return true if the path is acceptable
+   */
+  static bool decode_relative_path(const std::string &raw, std::string &out);
+
+  /**
+   * @brief Check an If-None-Match header against an entity tag
+   *
+   * @param header The If-None-Match value
+   * @param etag The current entity tag
+   * @return true if the tag matches (weak comparison) or the header is "*"
+   */
+  static bool etag_matches(const std::string &header, const std::string &etag);
+
+  /**
+   * @brief Parse an HTTP date (IMF-fixdate)
+   *
+   * @param value The header value
+   * @return std::time_t The parsed time, or -1 if it is not a valid date
+   */
+  static std::time_t parse_http_date(const std::string &value);
+};
+
+} // namespace fion
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "Handler.hpp"
+#include "RouteTree.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fion {
+
+/**
+ * @brief String literal usable as a template argument
+ *
+ * @tparam N Size of the literal, including the terminating NUL
+ */
+template <std::size_t N> struct FixedString {
+  char value[N]{};
+
+  constexpr FixedString(const char (&text)[N]) {
+    std::copy_n(text, N, value);
+  }
+
+  /**
+   * @brief Get the literal without its terminating NUL
+   *
+   * @return std::string_view The characters of the literal
+   */
+  constexpr std::string_view view(void) const { return {value, N - 1}; }
+};
+
+namespace detail {
+struct PatternSegment {
+  std::string_view text; ///< Literal text, or the parameter name
+  bool param = false;    ///< True for ":name" segments
+};
+
+constexpr std::size_t count_segments(std::string_view pattern) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '/' && (i == 0 || pattern[i - 1] == '/'))
+      ++count;
+  }
+  return count;
+}
+
+template <std::size_t Count>
+constexpr std::array<PatternSegment, Count>
+split_segments(std::string_view pattern) {
+  std::array<PatternSegment, Count> segments{};
+  std::size_t index = 0;
+  std::size_t position = 0;
+  while (index < Count) {
+    while (pattern[position] == '/')
+      ++position;
+    std::size_t end = position;
+    while (end < pattern.size() && pattern[end] != '/')
+      ++end;
+    std::string_view text = pattern.substr(position, end - position);
+    if (text.front() == ':')
+      segments[index++] = {text.substr(1), true};
+    else
+      segments[index++] = {text, false};
+    position = end;
+  }
+  return segments;
+}
+
+/**
+ * @brief A path pattern split into segments at compile time
+ *
+ * Matching is unrolled over the segments, so literal comparisons are
+ * against constants and no pattern data is inspected at run time. Paths are
+ * compared segment by segment, ignoring repeated and trailing slashes like
+ * the runtime Router.
+ */
+template <FixedString Pattern> struct CompiledPattern {
+  static constexpr std::string_view source = Pattern.view();
+  static constexpr std::size_t segment_count = count_segments(source);
+  static constexpr std::array<PatternSegment, segment_count> segments =
+      split_segments<segment_count>(source);
+  static constexpr std::size_t param_count =
+      std::count_if(segments.begin(), segments.end(),
+                    [](const PatternSegment &s) { return s.param; });
+
+  static_assert(!source.empty() && source.front() == '/',
+                "Route patterns must start with '/'");
+  static_assert(param_count <= MAX_ROUTE_PARAMS,
+                "Too many parameters in route pattern");
+  static_assert(MAX_ROUTE_PARAMS <= http::MAX_PATH_PARAMS,
+                "Requests must hold every route parameter");
+
+  template <std::size_t I>
+  static bool match_segment(std::string_view path, std::size_t &position,
+                            RouteParams &params) {
+    position = path.find_first_not_of('/', position);
+    if (position == std::string_view::npos)
+      return false;
+    std::size_t end = path.find('/', position);
+    if (end == std::string_view::npos)
+      end = path.size();
+    std::string_view segment = path.substr(position, end - position);
+    position = end;
+    if constexpr (segments[I].param) {
+      params.values[params.count++] = segment;
+      return true;
+    } else {
+      return segment == segments[I].text;
+    }
+  }
+
+  /**
+   * @brief Match a request path
+   *
+   * @param path The request path
+   * @param params Receives the parameter values, viewing @p path
+   * @return true if the path matches
+   */
+  static bool match(std::string_view path, RouteParams &params) {
+    params.count = 0;
+    std::size_t position = 0;
+    bool matched = [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return (match_segment<I>(path, position, params) && ...);
+    }(std::make_index_sequence<segment_count>{});
+    return matched &&
+           path.find_first_not_of('/', position) == std::string_view::npos;
+  }
+};
+} // namespace detail
+
+/**
+ * @brief Middleware applied in order before a statically dispatched handler
+ *
+ * Each type must be default-constructible and callable with
+ * std::unique_ptr<http::Request>&; it is constructed and called inline.
+ *
+ * @tparam Middleware The middleware types
+ */
+template <typename... Middleware> struct MiddlewareChain {
+  static_assert(
+      (std::is_invocable_v<Middleware, std::unique_ptr<http::Request> &> &&
+       ...),
+      "Middleware must be callable with std::unique_ptr<http::Request>&");
+
+  static void run(std::unique_ptr<http::Request> &request) {
+    (Middleware{}(request), ...);
+  }
+};
+
+/**
+ * @brief Route known at compile time
+ *
+ * The handler type must be default-constructible and provide the Handler
+ * interface's handle() signature. One instance is created per route and
+ * called without virtual dispatch, so the call can be inlined.
+ *
+ * @tparam Method HTTP method of the route
+ * @tparam Pattern Path pattern with optional ":name" segments
+ * @tparam HandlerType The handler type
+ * @tparam Chain The route's MiddlewareChain
+ */
+template <http::Method Method, FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+struct StaticRoute {
+  using Compiled = detail::CompiledPattern<Pattern>;
+  static constexpr http::Method method = Method;
+
+  static_assert(std::is_default_constructible_v<HandlerType>,
+                "Static route handlers must be default-constructible");
+  static_assert(
+      std::is_same_v<decltype(std::declval<HandlerType &>().handle(
+                         std::declval<std::unique_ptr<http::Request>>())),
+                     std::unique_ptr<http::Response>>,
+      "Static route handlers must provide the Handler::handle signature");
+
+  /**
+   * @brief Run the middleware chain and the handler
+   *
+   * @param request The matched request
+   * @param params Parameter values captured by the pattern
+   * @return std::unique_ptr<http::Response> The handler's response
+   */
+  static std::unique_ptr<http::Response>
+  invoke(std::unique_ptr<http::Request> request, const RouteParams &params) {
+    // Same request contract as the runtime Router
+    static const std::vector<std::string> names = [] {
+      std::vector<std::string> keys;
+      for (const auto &segment : Compiled::segments) {
+        if (segment.param)
+          keys.emplace_back(segment.text);
+      }
+      return keys;
+    }();
+    request->setParams(&names, params.values.data(), params.count);
+    Chain::run(request);
+    static HandlerType handler;
+    return handler.HandlerType::handle(std::move(request));
+  }
+};
+
+template <FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+using Get = StaticRoute<http::Method::GET, Pattern, HandlerType, Chain>;
+template <FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+using Post = StaticRoute<http::Method::POST, Pattern, HandlerType, Chain>;
+template <FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+using Put = StaticRoute<http::Method::PUT, Pattern, HandlerType, Chain>;
+template <FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+using Delete = StaticRoute<http::Method::DELETE, Pattern, HandlerType, Chain>;
+template <FixedString Pattern, typename HandlerType,
+          typename Chain = MiddlewareChain<>>
+using Patch = StaticRoute<http::Method::PATCH, Pattern, HandlerType, Chain>;
+
+/**
+ * @brief Route table resolved entirely at compile time
+ *
+ * Routes are tried in declaration order; HEAD requests fall back to GET
+ * routes. dispatch() has the DispatchFunction signature, so the table
+ * replaces the runtime Router in Server and Pool:
+ *
+ * @code
+ * using Routes = fion::RouteTable<
+ *     fion::Get<"/", HomeHandler>,
+ *     fion::Get<"/users/:id", UserHandler, fion::MiddlewareChain<Auth>>>;
+ * app.useStaticRoutes<Routes>();
+ * @endcode
+ *
+ * @tparam Routes The StaticRoute types
+ */
+template <typename... Routes> struct RouteTable {
+private:
+  template <typename Route>
+  static bool try_route(http::Method method, std::string_view path,
+                        std::unique_ptr<http::Request> &request,
+                        std::unique_ptr<http::Response> &response) {
+    if (Route::method != method)
+      return false;
+    RouteParams params;
+    if (!Route::Compiled::match(path, params))
+      return false;
+    response = Route::invoke(std::move(request), params);
+    return true;
+  }
+
+  static bool dispatch_method(http::Method method, std::string_view path,
+                              std::unique_ptr<http::Request> &request,
+                              std::unique_ptr<http::Response> &response) {
+    return (try_route<Routes>(method, path, request, response) || ...);
+  }
+
+public:
+  /**
+   * @brief Route a request to its handler
+   *
+   * @param request The parsed request
+   * @return std::unique_ptr<http::Response> The handler's response, or
+   * nullptr if no route matches
+   */
+  static std::unique_ptr<http::Response>
+  dispatch(std::unique_ptr<http::Request> request) {
+    const http::Method method = request->getMethod();
+    // Views the request, which outlives every attempt that does not match
+    const std::string_view path = request->getPath();
+    std::unique_ptr<http::Response> response;
+    if (!dispatch_method(method, path, request, response) &&
+        method == http::Method::HEAD)
+      dispatch_method(http::Method::GET, path, request, response);
+    return response;
+  }
+};
+
+} // namespace fion
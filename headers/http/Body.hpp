@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <variant>
+#include <vector>
+
+#include "http/BodyWriter.hpp"
+
+namespace fion::http {
+/**
+ * @brief Owning wrapper around an open file descriptor
+ *
+ * The descriptor is closed when the last owner releases it, which lets
+ * several responses (or a cache) share one open file without copying it.
+ */
+class FileHandle {
+private:
+  int _fd; ///< The owned file descriptor
+
+public:
+  /**
+   * @brief Take ownership of an open file descriptor
+   *
+   * @param fd The descriptor to own
+   * @throws std::invalid_argument if fd is negative
+   */
+  explicit FileHandle(int fd);
+
+  /**
+   * @brief Close the owned file descriptor
+   */
+  ~FileHandle(void);
+
+  // Prevent copying (the descriptor has a single owner)
+  FileHandle(const FileHandle &) = delete;
+  FileHandle &operator=(const FileHandle &) = delete;
+
+  /**
+   * @brief Get the owned file descriptor
+   *
+   * @return int The file descriptor
+   */
+  int get_fd(void) const { return _fd; }
+};
+
+/**
+ * @brief Immutable, reference-counted byte range shared between responses
+ *
+ * The view points into memory kept alive by @p owner; copying a
+ * SharedBuffer only bumps the reference count and never copies the bytes.
+ */
+struct SharedBuffer {
+  std::shared_ptr<const void> owner; ///< Keeps the viewed memory alive
+  std::string_view data;             ///< The bytes to send
+
+  /**
+   * @brief Move a string into a new shared buffer
+   *
+   * @param content The bytes to share
+   * @return SharedBuffer A buffer viewing the moved string
+   */
+  static SharedBuffer fromString(std::string content);
+};
+
+/**
+ * @brief A region of an open file, sent with sendfile(2)
+ */
+struct FileRegion {
+  std::shared_ptr<const FileHandle> file; ///< The file to read from
+  off_t offset = 0;                       ///< First byte of the region
+  std::size_t length = 0;                 ///< Number of bytes to send
+
+  /**
+   * @brief Open a file and describe its whole content
+   *
+   * @param path The path of the file to open
+   * @return FileRegion A region covering the complete file
+   * @throws std::runtime_error if the file cannot be opened or inspected
+   */
+  static FileRegion fromPath(const std::string &path);
+};
+
+/**
+ * @brief Pull-based body producer
+ *
+ * Called each time the connection can accept more data. The generator
+ * stores the next chunk in @p chunk and returns true, or returns false
+ * once the body is complete.
+ */
+using BodyGenerator = std::function<bool(std::string &chunk)>;
+
+/**
+ * @brief Kinds of content a response body can hold
+ */
+enum class BodyKind {
+  STRING,    ///< Bytes owned by the response
+  SHARED,    ///< Reference-counted immutable buffer
+  FILE,      ///< Region of an open file
+  GENERATOR, ///< Chunks pulled on demand
+  STREAM,    ///< Chunks pushed through a BodyWriter with back-pressure
+  SEQUENCE,  ///< Sized bodies sent back to back
+};
+
+class Body;
+
+/**
+ * @brief Bodies sent one after the other as a single body
+ *
+ * Lets a response mix in-memory and file-backed parts (e.g. the parts of a
+ * multipart/byteranges response) while each part keeps its own send path.
+ */
+using BodyParts = std::vector<Body>;
+
+/**
+ * @brief HTTP message body
+ *
+ * A body is either an owned string, a shared immutable buffer, a file
+ * region, a generator, a stream or a sequence of sized bodies. Each kind is written to the socket with
+ * the cheapest system call available for it, so handlers returning large
+ * payloads never duplicate them in memory.
+ */
+class Body {
+private:
+  std::variant<std::string, SharedBuffer, FileRegion, BodyGenerator,
+               std::shared_ptr<BodyWriter>, BodyParts>
+      _content;
+
+public:
+  Body(void) = default;
+  Body(std::string content) : _content(std::move(content)) {}
+  Body(const char *content) : _content(std::string(content)) {}
+  Body(SharedBuffer content) : _content(std::move(content)) {}
+  Body(FileRegion content) : _content(std::move(content)) {}
+  Body(BodyGenerator content) : _content(std::move(content)) {}
+  Body(std::shared_ptr<BodyWriter> content) : _content(std::move(content)) {}
+
+  /**
+   * @brief Concatenate sized bodies
+   *
+   * @param parts The parts, in sending order
+   * @throws std::invalid_argument if a part has no known size
+   */
+  Body(BodyParts parts);
+
+  /**
+   * @brief Get the kind of content held by the body
+   *
+   * @return BodyKind The active alternative
+   */
+  BodyKind kind(void) const { return static_cast<BodyKind>(_content.index()); }
+
+  /**
+   * @brief Get the body size when it is known up front
+   *
+   * @return std::optional<std::size_t> The size, or std::nullopt for
+   * generators and streams
+   */
+  std::optional<std::size_t> size(void) const;
+
+  /**
+   * @brief Check whether the body is known to be empty
+   *
+   * @return true if the body has a known size of zero
+   */
+  bool empty(void) const { return size() == std::optional<std::size_t>(0); }
+
+  /**
+   * @brief Get a view of in-memory content
+   *
+   * @return std::string_view The bytes of a STRING or SHARED body, or an
+   * empty view for the other kinds
+   */
+  std::string_view view(void) const;
+
+  /**
+   * @brief Get the owned string (STRING bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not a STRING
+   */
+  const std::string &asString(void) const {
+    return std::get<std::string>(_content);
+  }
+
+  /**
+   * @brief Get the shared buffer (SHARED bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not SHARED
+   */
+  const SharedBuffer &asShared(void) const {
+    return std::get<SharedBuffer>(_content);
+  }
+
+  /**
+   * @brief Get the file region (FILE bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not a FILE
+   */
+  const FileRegion &asFile(void) const {
+    return std::get<FileRegion>(_content);
+  }
+
+  /**
+   * @brief Get the generator (GENERATOR bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not a GENERATOR
+   */
+  const BodyGenerator &asGenerator(void) const {
+    return std::get<BodyGenerator>(_content);
+  }
+
+  /**
+   * @brief Get the stream writer (STREAM bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not a STREAM
+   */
+  const std::shared_ptr<BodyWriter> &asStream(void) const {
+    return std::get<std::shared_ptr<BodyWriter>>(_content);
+  }
+
+  /**
+   * @brief Get the parts (SEQUENCE bodies only)
+   *
+   * @throws std::bad_variant_access if the body is not a SEQUENCE
+   */
+  const BodyParts &asSequence(void) const {
+    return std::get<BodyParts>(_content);
+  }
+
+  /**
+   * @brief Copy the whole body into a string
+   *
+   * File regions are read with pread(2) and generators and streams are
+   * drained, so this is meant for debugging and tests rather than the send
+   * path.
+   *
+   * @return std::string The materialized body
+   * @throws std::runtime_error if a file region cannot be read
+   */
+  std::string materialize(void) const;
+};
+
+} // namespace fion::http
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace fion::http {
+/**
+ * @brief Push-based writer for streamed response bodies
+ *
+ * A handler that cannot (or should not) build its body in memory returns a
+ * response whose body is a BodyWriter. The connection calls the producer
+ * whenever the amount of queued data is below the high-water mark; the
+ * producer writes chunks until write() returns false, then returns. It is
+ * called again once the socket has drained the queue, so at most about one
+ * high-water mark of data is held in memory at a time.
+ *
+ * Bodies of unknown length are framed with Transfer-Encoding: chunked;
+ * setting Content-Length on the response sends the chunks raw instead.
+ */
+class BodyWriter {
+public:
+  /**
+   * @brief Called when the writer can accept more data
+   */
+  using Producer = std::function<void(BodyWriter &writer)>;
+
+  /// Default amount of queued data above which write() asks to stop
+  static constexpr std::size_t DEFAULT_HIGH_WATER_MARK = 64 * 1024;
+
+private:
+  Producer _producer;
+  std::size_t _highWaterMark;
+  std::deque<std::string> _chunks;
+  std::size_t _pending;
+  bool _ended;
+  bool _stalled;
+  std::function<void()> _resume;
+  mutable std::mutex _mutex;
+
+public:
+  /**
+   * @brief Construct a new Body Writer object
+   *
+   * @param producer Function called whenever more data can be written; may
+   * be empty when chunks are pushed from elsewhere
+   * @param highWaterMark Queued bytes above which write() returns false
+   */
+  explicit BodyWriter(Producer producer,
+                      std::size_t highWaterMark = DEFAULT_HIGH_WATER_MARK);
+
+  // Prevent copying and moving (the connection holds it by pointer)
+  BodyWriter(const BodyWriter &) = delete;
+  BodyWriter &operator=(const BodyWriter &) = delete;
+  BodyWriter(BodyWriter &&) = delete;
+  BodyWriter &operator=(BodyWriter &&) = delete;
+
+  /**
+   * @brief Queue a chunk of the body
+   *
+   * @param chunk The bytes to send; empty chunks are ignored
+   * @return true if more data may be written right away
+   * @return false if the queue crossed the high-water mark; the producer
+   * should return and wait to be called again
+   * @throws std::logic_error if the body was already ended
+   */
+  bool write(std::string chunk);
+
+  /**
+   * @brief Mark the body as complete
+   */
+  void end();
+
+  /**
+   * @brief Check if the body was ended
+   *
+   * @return true once end() has been called
+   */
+  bool ended() const;
+
+  /**
+   * @brief Get the number of queued bytes not yet taken by the connection
+   *
+   * @return std::size_t The queued byte count
+   */
+  std::size_t pending() const;
+
+  /**
+   * @brief Get the high-water mark
+   *
+   * @return std::size_t The configured high-water mark in bytes
+   */
+  std::size_t high_water_mark() const { return _highWaterMark; }
+
+  /**
+   * @brief Run the producer if the queue is below the high-water mark
+   *
+   * Used by the connection before taking chunks.
+   */
+  void pump();
+
+  /**
+   * @brief Take the oldest queued chunk
+   *
+   * When nothing is queued and the body is not ended, the writer is marked
+   * as stalled and the resume callback fires on the next write() or end().
+   *
+   * @return std::optional<std::string> The chunk, or std::nullopt if the
+   * queue is empty
+   */
+  std::optional<std::string> take();
+
+  /**
+   * @brief Set the function called when a stalled writer receives data
+   *
+   * @param resume The callback, invoked on the thread calling write()/end(),
+   * possibly from inside pump(); it should only schedule the resumption
+   */
+  void set_resume_callback(std::function<void()> resume);
+};
+
+} // namespace fion::http
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fion::http {
@@ -11,15 +14,54 @@ namespace fion::http {
  *
  * This class provides a clean interface for managing HTTP headers,
  * including adding, retrieving, checking existence, and removing headers.
+ * Names are compared ignoring ASCII case, as HTTP does: "content-length"
+ * finds "Content-Length", and setting it keeps the name first stored.
  */
 class Headers {
+public:
+  /**
+   * @brief Orders header names ignoring ASCII case
+   *
+   * Transparent, so lookups need no std::string.
+   */
+  struct NameLess {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const {
+      return std::lexicographical_compare(
+          a.begin(), a.end(), b.begin(), b.end(),
+          [](unsigned char x, unsigned char y) {
+            return (x >= 'A' && x <= 'Z' ? x + 32 : x) <
+                   (y >= 'A' && y <= 'Z' ? y + 32 : y);
+          });
+    }
+  };
+
+  /**
+   * @brief Header storage, keyed by name regardless of case
+   */
+  using Map = std::map<std::string, std::string, NameLess>;
+
 private:
-  std::map<std::string, std::string> _headers;
+
+  /**
+   * @brief Most entries kept for reuse by recycle()
+   */
+  static constexpr std::size_t MAX_SPARE_ENTRIES = 64;
+
+  Map _headers;
+  std::vector<Map::node_type> _spare; ///< Recycled entries, never copied
+
+  void assign(std::string_view key, std::string_view value);
 
 public:
   Headers(void);
   ~Headers(void);
 
+  Headers(const Headers &other);
+  Headers &operator=(const Headers &other);
+  Headers(Headers &&other) = default;
+  Headers &operator=(Headers &&other) = default;
+
   /**
    * @brief Set a header key-value pair
    *
@@ -76,6 +118,14 @@ public:
    */
   void clear(void);
 
+  /**
+   * @brief Clear all headers, keeping their entries for reuse
+   *
+   * Later insertions take a recycled entry, keeping the capacity of its
+   * strings, instead of allocating one.
+   */
+  void recycle(void);
+
   /**
    * @brief Get all header keys
    *
@@ -102,7 +152,7 @@ public:
    *
    * @return A const reference to the headers map
    */
-  const std::map<std::string, std::string> &getAll(void) const;
+  const Map &getAll(void) const;
 
   /**
    * @brief Parse headers from a raw string
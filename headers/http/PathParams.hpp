@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fion::http {
+/**
+ * @brief Most path parameters stored on a request
+ */
+constexpr std::size_t MAX_PATH_PARAMS = 16;
+
+/**
+ * @brief Path parameters captured by the router
+ *
+ * Values are stored as positions in the request path rather than copies, so
+ * filling and copying them does not allocate; names point into the route
+ * table, which outlives the handling of the request. Values that are not part of the path (e.g. taken from a
+ * normalized copy of it) are kept in a side buffer, which is the only case
+ * that allocates. Accessors take the path the positions refer to; use them
+ * through Request.
+ */
+class PathParams {
+public:
+  using Names = const std::vector<std::string> *;
+
+private:
+  static constexpr std::uint32_t STORED = 0x80000000u; ///< Offset flag
+
+  Names _names = nullptr;
+  std::array<std::pair<std::uint32_t, std::uint32_t>, MAX_PATH_PARAMS>
+      _spans{}; ///< Offset and length of each value
+  std::size_t _count = 0;
+  std::string _storage; ///< Values that do not view the path
+
+public:
+  /**
+   * @brief Replace the parameters
+   *
+   * @param path The request path the values should refer to
+   * @param names Parameter names, in capture order
+   * @param values Captured values
+   * @param count Number of values
+   * @throws std::length_error if count exceeds MAX_PATH_PARAMS
+   */
+  void assign(std::string_view path, Names names,
+              const std::string_view *values, std::size_t count);
+
+  /**
+   * @brief Remove every parameter
+   */
+  void clear(void);
+
+  /**
+   * @brief Get the number of parameters
+   *
+   * @return std::size_t The number of captured values
+   */
+  std::size_t size(void) const { return _count; }
+
+  /**
+   * @brief Get the name of a parameter
+   *
+   * @param index Capture index
+   * @return std::string_view The name, empty if the route named none
+   */
+  std::string_view name(std::size_t index) const;
+
+  /**
+   * @brief Get the value of a parameter
+   *
+   * @param path The path given to assign()
+   * @param index Capture index
+   * @return std::string_view The value
+   */
+  std::string_view value(std::string_view path, std::size_t index) const;
+
+  /**
+   * @brief Find a parameter by name
+   *
+   * @param path The path given to assign()
+   * @param name The parameter name
+   * @return std::optional<std::string_view> The value, if captured
+   */
+  std::optional<std::string_view> find(std::string_view path,
+                                       std::string_view name) const;
+};
+
+} // namespace fion::http
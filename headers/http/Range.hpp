@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "http/Response.hpp"
+
+namespace fion::http {
+/**
+ * @brief Most ranges honoured in one request
+ *
+ * Requests asking for more are served in full, which keeps clients from
+ * turning a small file into a huge multipart response.
+ */
+constexpr std::size_t MAX_BYTE_RANGES = 32;
+
+/**
+ * @brief Inclusive byte range of a representation
+ */
+struct ByteRange {
+  std::size_t first; ///< First byte position
+  std::size_t last;  ///< Last byte position (inclusive)
+
+  /**
+   * @brief Get the number of bytes in the range
+   *
+   * @return std::size_t last - first + 1
+   */
+  std::size_t length(void) const { return last - first + 1; }
+};
+
+/**
+ * @brief Parse a Range header against a representation size
+ *
+ * Ranges are clamped to the representation, sorted and coalesced when they
+ * overlap or touch.
+ *
+ * @param header The Range header value (e.g. "bytes=0-99,-500")
+ * @param size The size of the full representation
+ * @return std::optional<std::vector<ByteRange>> std::nullopt if the header
+ * must be ignored (malformed, another unit or too many ranges), an empty
+ * vector if no range is satisfiable, otherwise the ranges to send
+ */
+std::optional<std::vector<ByteRange>> parseRange(std::string_view header,
+                                                 std::size_t size);
+
+/**
+ * @brief Turn a full 200 response into a partial one
+ *
+ * Applies to STRING, SHARED and FILE bodies: one range becomes a 206 with a
+ * Content-Range header, several become a multipart/byteranges body whose
+ * parts still point into the original buffer or file (file parts are sent
+ * with sendfile(2)), and unsatisfiable ranges become a 416. An If-Range
+ * value that does not match the response's strong ETag or Last-Modified
+ * date leaves the response untouched.
+ *
+ * @param response The response produced by the handler
+ * @param range The request's Range header value
+ * @param ifRange The request's If-Range header value, empty if absent
+ * @return true if the response was changed
+ */
+bool applyRange(Response &response, std::string_view range,
+                std::string_view ifRange);
+} // namespace fion::http
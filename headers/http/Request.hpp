@@ -1,9 +1,14 @@
 #pragma once
 
+#include <charconv>
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include "http/Headers.hpp"
+#include "http/PathParams.hpp"
 #include "http/URL.hpp"
 #include "http/Version.hpp"
 
@@ -42,6 +47,14 @@ enum class Method {
  */
 const Method stringToMethod(std::string rawMethod);
 
+/**
+ * @brief Convert an HTTP Method enum to its string representation
+ *
+ * @param method The HTTP method enum
+ * @return The method name (e.g., "GET")
+ */
+const std::string methodToString(const Method method);
+
 /**
  * @brief Represents an HTTP request
  *
@@ -56,12 +69,18 @@ private:
   Version _version;
   Headers _headers;
   std::string _body;
+  PathParams _params;
 
   void parseStartLine(const std::string &rawStartLine);
   void parseHeaders(const std::string &rawHeaders);
   void parseBody(const std::string &rawBody);
 
 public:
+  /**
+   * @brief Construct an empty GET request, to be filled by parse()
+   */
+  Request(void);
+
   /**
    * @brief Construct a new Request object from raw HTTP request data
    *
@@ -79,6 +98,20 @@ public:
    */
   ~Request(void);
 
+  /**
+   * @brief Replace the request with newly received data
+   *
+   * Reuses the storage of the previous request (body capacity, header
+   * entries), so a recycled Request parses without most allocations.
+   *
+   * @param rawStartLine The HTTP request start line
+   * @param rawHeaders The raw headers string
+   * @param rawBody The request body
+   * @throws std::invalid_argument if any part of the request is invalid
+   */
+  void parse(const std::string &rawStartLine, const std::string &rawHeaders,
+             const std::string &rawBody);
+
   /**
    * @brief Get the HTTP method of the request
    *
@@ -93,6 +126,13 @@ public:
    */
   URL getURL(void) const { return _URL; }
 
+  /**
+   * @brief Get the path to the resource without copying the URL
+   *
+   * @return Const reference to the path
+   */
+  const std::string &getPath(void) const { return _URL.getPathToResource(); }
+
   /**
    * @brief Get the HTTP version of the request
    *
@@ -131,6 +171,78 @@ public:
    * @return The request body as a string
    */
   std::string getBody(void) const { return _body; }
+
+  /**
+   * @brief Set the path parameters captured by the router
+   *
+   * Values viewing getPath() are stored as positions and do not allocate.
+   *
+   * @param names Parameter names, in capture order
+   * @param values Captured values
+   * @param count Number of values
+   * @throws std::length_error if count exceeds MAX_PATH_PARAMS
+   */
+  void setParams(PathParams::Names names, const std::string_view *values,
+                 std::size_t count) {
+    _params.assign(getPath(), names, values, count);
+  }
+
+  /**
+   * @brief Get the number of path parameters
+   *
+   * @return std::size_t The number of captured values
+   */
+  std::size_t paramCount(void) const { return _params.size(); }
+
+  /**
+   * @brief Check whether a path parameter was captured
+   *
+   * @param name The parameter name (e.g., "id" for "/users/:id")
+   * @return true if the route captured it
+   */
+  bool hasParam(std::string_view name) const {
+    return _params.find(getPath(), name).has_value();
+  }
+
+  /**
+   * @brief Get a path parameter
+   *
+   * @param name The parameter name (e.g., "id" for "/users/:id")
+   * @return std::string_view The value, valid while the request lives
+   * @throws std::invalid_argument if the parameter was not captured
+   */
+  std::string_view param(std::string_view name) const {
+    auto value = _params.find(getPath(), name);
+    if (!value)
+      throw std::invalid_argument("Path parameter not found: " +
+                                  std::string(name));
+    return *value;
+  }
+
+  /**
+   * @brief Get a path parameter converted to a number
+   *
+   * @tparam T An arithmetic type other than bool
+   * @param name The parameter name
+   * @return T The parsed value; the whole value must be a number
+   * @throws std::invalid_argument if the parameter is missing or not a number
+   * @throws std::out_of_range if the number does not fit in T
+   */
+  template <typename T>
+    requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+  T param(std::string_view name) const {
+    std::string_view text = param(name);
+    T value{};
+    auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error == std::errc::result_out_of_range)
+      throw std::out_of_range("Path parameter out of range: " +
+                              std::string(name));
+    if (error != std::errc() || end != text.data() + text.size())
+      throw std::invalid_argument("Invalid path parameter: " +
+                                  std::string(name));
+    return value;
+  }
 };
 
 } // namespace fion::http
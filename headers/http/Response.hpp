@@ -3,7 +3,9 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <utility>
 
+#include "http/Body.hpp"
 #include "http/Headers.hpp"
 #include "http/Version.hpp"
 
@@ -174,7 +176,7 @@ private:
   Version _version;
   StatusCode _statusCode;
   Headers _headers;
-  std::string _body;
+  Body _body;
 
 public:
   /**
@@ -218,6 +220,90 @@ public:
    */
   void setBody(const std::string &body) { _body = body; }
 
+  /**
+   * @brief Set the response body without copying it
+   *
+   * @param body The response body content, moved into the response
+   */
+  void setBody(std::string &&body) { _body = std::move(body); }
+
+  /**
+   * @brief Set the response body from a string literal
+   *
+   * @param body The response body content
+   */
+  void setBody(const char *body) { _body = body; }
+
+  /**
+   * @brief Set the response body to any kind of body
+   *
+   * Shared buffers, file regions and generators are sent without being
+   * copied into the response.
+   *
+   * @param body The response body
+   */
+  void setBody(Body body) { _body = std::move(body); }
+
+  /**
+   * @brief Stream the response body through a BodyWriter
+   *
+   * The producer is called on the connection's thread whenever less than
+   * @p highWaterMark bytes are queued. Unless Content-Length is set, the
+   * body is sent with Transfer-Encoding: chunked.
+   *
+   * @param producer Function writing the next chunks of the body
+   * @param highWaterMark Queued bytes above which write() returns false
+   * @return std::shared_ptr<BodyWriter> The writer bound to the response
+   */
+  std::shared_ptr<BodyWriter> setStreamingBody(
+      BodyWriter::Producer producer,
+      std::size_t highWaterMark = BodyWriter::DEFAULT_HIGH_WATER_MARK) {
+    auto writer =
+        std::make_shared<BodyWriter>(std::move(producer), highWaterMark);
+    _body = writer;
+    return writer;
+  }
+
+  /**
+   * @brief Get the response body
+   *
+   * @return Const reference to the body
+   */
+  const Body &getBody(void) const { return _body; }
+
+  /**
+   * @brief Take the body out of the response
+   *
+   * @return Body The body; the response is left with an empty body
+   */
+  Body releaseBody(void) { return std::exchange(_body, Body()); }
+
+  /**
+   * @brief Return to the state of a new Response, for reuse
+   *
+   * Header entries are kept for reuse (see Headers::recycle()).
+   */
+  void reset(void) {
+    _version = Version::HTTP_1_1;
+    _statusCode = StatusCode::OK;
+    _headers.recycle();
+    _body = Body();
+  }
+
+  /**
+   * @brief Get the status code of the response
+   *
+   * @return The HTTP status code
+   */
+  StatusCode getStatusCode(void) const { return _statusCode; }
+
+  /**
+   * @brief Get the HTTP version of the response
+   *
+   * @return The HTTP version
+   */
+  Version getVersion(void) const { return _version; }
+
   /**
    * @brief Get the headers object (mutable)
    *
@@ -232,9 +318,19 @@ public:
    */
   const Headers &getHeaders(void) const { return _headers; }
 
+  /**
+   * @brief Serialize the status line, headers and the blank line after them
+   *
+   * @return The raw HTTP response head
+   */
+  std::string toRawHead(void) const;
+
   /**
    * @brief Convert the response to raw HTTP response format
    *
+   * The body is materialized (see Body::materialize), so the send path uses
+   * toRawHead() and writes the body separately.
+   *
    * @return The raw HTTP response string with status line, headers, and body
    */
   const std::string toRawResponse(void) const;
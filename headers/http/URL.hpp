@@ -76,7 +76,7 @@ public:
    *
    * @return The resource path
    */
-  std::string getPathToResource(void) const;
+  const std::string &getPathToResource(void) const;
 
   /**
    * @brief Get the query parameters
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "http/Body.hpp"
+#include "network/QueueDelayController.hpp"
+#include "network/ServerOptions.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace fion::network {
+/**
+ * @brief Admission counters of a server
+ *
+ * The queue delay totals cover the worker queue and the loops of the pools
+ * serving or draining; a retired pool's counts leave them with it.
+ */
+struct AdmissionStats {
+  std::size_t connections = 0; ///< Connections currently open
+  std::size_t queuedTasks = 0; ///< Offloaded requests waiting for a worker
+  std::uint64_t rejectedConnections = 0; ///< Global or per-pool cap reached
+  std::uint64_t rejectedRequests = 0;    ///< A route's bulkhead was full
+  std::uint64_t rejectedTasks = 0;       ///< The worker queue was full
+  std::uint64_t shedRequests = 0;        ///< Waited too long, any queue
+  bool overloaded = false; ///< One of the delay controllers is shedding
+  std::chrono::microseconds queueDelay{0}; ///< Largest of the queues' last
+                                           ///< delays measured
+  QueueDelayController::Stats workerQueue; ///< Waiting for a worker
+  std::vector<QueueDelayController::Stats> poolQueues; ///< Per I/O pool
+};
+
+/**
+ * @brief Enforces the server's connection and queue caps
+ *
+ * Shared by the accept thread and every pool; all counters are atomic.
+ * With ServerOptions::queueDelayTarget set, a QueueDelayController also
+ * sheds offloaded requests that waited too long for a worker under
+ * sustained load; each pool has its own for its loop (see Pool).
+ * Rejections are answered with a 503 serialized once at startup, so
+ * shedding load costs one write and no allocation, or with a plain close
+ * (see OverloadAction).
+ */
+class AdmissionControl {
+private:
+  const std::size_t _maxConnections;
+  const std::size_t _maxQueuedTasks;
+  const OverloadAction _action;
+  http::SharedBuffer _rejection; ///< Complete 503 response
+  std::unique_ptr<QueueDelayController> _taskDelay; ///< Worker queue's;
+                                                    ///< null when disabled
+
+  std::atomic<std::size_t> _connections{0};
+  std::atomic<std::size_t> _queuedTasks{0};
+  std::atomic<std::uint64_t> _rejectedConnections{0};
+  std::atomic<std::uint64_t> _rejectedRequests{0};
+  std::atomic<std::uint64_t> _rejectedTasks{0};
+
+public:
+  /**
+   * @brief Construct a new Admission Control object
+   *
+   * @param options Caps, overload action and Retry-After delay
+   */
+  explicit AdmissionControl(const ServerOptions &options);
+
+  // Prevent copying (shared by pointer)
+  AdmissionControl(const AdmissionControl &) = delete;
+  AdmissionControl &operator=(const AdmissionControl &) = delete;
+
+  /**
+   * @brief Count a new connection if the global cap allows it
+   *
+   * @return true if admitted; release_connection() must follow
+   */
+  bool admit_connection(void);
+
+  /**
+   * @brief Forget a connection admitted earlier
+   */
+  void release_connection(void) {
+    _connections.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Count a connection turned away by a per-pool cap
+   */
+  void count_rejected_connection(void) {
+    _rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Turn away a connection that was not admitted
+   *
+   * Writes the 503 without blocking (unless the action is CLOSE) and
+   * closes the socket.
+   *
+   * @param fd The accepted socket
+   */
+  void reject_connection(int fd);
+
+  /**
+   * @brief Count an offloaded request if the worker queue has room
+   *
+   * @return true if admitted; task_started() must follow
+   */
+  bool admit_task(void);
+
+  /**
+   * @brief Forget a queued task once a worker picked it up
+   *
+   * Also called when the worker pool refused the task (it is stopping).
+   */
+  void task_started(void) {
+    _queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Decide on an offloaded request from how long it waited
+   *
+   * @param delay Time since it was queued for a worker
+   * @return true to serve it, false to shed it
+   */
+  bool admit_task_delay(QueueDelayController::Clock::duration delay) {
+    return !_taskDelay || _taskDelay->admit(delay);
+  }
+
+  /**
+   * @brief Check whether the worker queue's delay is measured at all
+   *
+   * @return true if adaptive shedding is enabled
+   */
+  bool measures_task_delay(void) const { return _taskDelay != nullptr; }
+
+  /**
+   * @brief Count a request turned away by a route's bulkhead
+   */
+  void count_rejected_request(void) {
+    _rejectedRequests.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the pre-serialized 503 response
+   *
+   * @return const http::SharedBuffer& The response bytes, shared
+   */
+  const http::SharedBuffer &rejection(void) const { return _rejection; }
+
+  /**
+   * @brief Get what is done with rejected requests
+   *
+   * @return OverloadAction Send the 503 or just close
+   */
+  OverloadAction action(void) const { return _action; }
+
+  /**
+   * @brief Get the counters; safe to call from any thread
+   *
+   * @param poolQueues The delay controller states of the I/O pools, added
+   * to the totals
+   * @return AdmissionStats The current counters
+   */
+  AdmissionStats
+  stats(std::vector<QueueDelayController::Stats> poolQueues = {}) const;
+};
+} // namespace fion::network
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "AsyncTask.hpp"
+#include "http/BodyWriter.hpp"
+#include "network/EventLoop.hpp"
+#include "network/ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace fion::network {
+/**
+ * @brief Get the event loop of the calling thread, for awaitables
+ *
+ * @return EventLoop& The loop running on this thread
+ * @throws std::logic_error if no event loop runs on this thread
+ */
+EventLoop &current_loop(void);
+
+/**
+ * @brief Awaitable that resumes after a delay
+ */
+class SleepAwaiter {
+private:
+  std::chrono::milliseconds _delay;
+
+public:
+  explicit SleepAwaiter(std::chrono::milliseconds delay) : _delay(delay) {}
+
+  bool await_ready(void) const noexcept { return _delay.count() <= 0; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume(void) const noexcept {}
+};
+
+/**
+ * @brief Suspend the coroutine for a while without blocking its loop
+ *
+ * @param delay Time to wait
+ * @return SleepAwaiter Resumes on the same event loop thread
+ */
+inline SleepAwaiter sleep_for(std::chrono::milliseconds delay) {
+  return SleepAwaiter(delay);
+}
+
+/**
+ * @brief Awaitable that resumes once a descriptor is ready
+ */
+class ReadyAwaiter {
+private:
+  int _fd;
+  uint32_t _events;
+  uint32_t _fired = 0;
+
+public:
+  ReadyAwaiter(int fd, uint32_t events) : _fd(fd), _events(events) {}
+
+  bool await_ready(void) const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  uint32_t await_resume(void) const noexcept { return _fired; }
+};
+
+/**
+ * @brief Suspend until a non-blocking descriptor can be read
+ *
+ * The descriptor must not be registered with the loop otherwise (it
+ * cannot be one of the server's client sockets).
+ *
+ * @param fd The descriptor
+ * @return ReadyAwaiter Resumes with the PollerEvent flags that fired
+ */
+inline ReadyAwaiter wait_readable(int fd) {
+  return ReadyAwaiter(fd, static_cast<uint32_t>(PollerEvent::READ));
+}
+
+/**
+ * @brief Suspend until a non-blocking descriptor can be written
+ *
+ * @param fd The descriptor
+ * @return ReadyAwaiter Resumes with the PollerEvent flags that fired
+ */
+inline ReadyAwaiter wait_writable(int fd) {
+  return ReadyAwaiter(fd, static_cast<uint32_t>(PollerEvent::WRITE));
+}
+
+/**
+ * @brief Awaitable that runs a function on a ThreadPool
+ *
+ * The coroutine resumes on the loop it was suspended on once the function
+ * returned, with its result (or exception). If the pool is stopping and
+ * drops the function, it resumes right away with a std::runtime_error.
+ *
+ * @tparam F A callable taking no arguments
+ */
+template <typename F> class OffloadAwaiter {
+private:
+  using Result = std::invoke_result_t<F &>;
+  using Stored =
+      std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>>;
+
+  ThreadPool *_pool;
+  F _function;
+  Stored _result{};
+  std::exception_ptr _exception;
+
+  void invoke(void) {
+    try {
+      if constexpr (std::is_void_v<Result>)
+        _function();
+      else
+        _result.emplace(_function());
+    } catch (...) {
+      _exception = std::current_exception();
+    }
+  }
+
+public:
+  OffloadAwaiter(ThreadPool *pool, F function)
+      : _pool(pool), _function(std::move(function)) {}
+
+  // Without a pool the function runs inline when resumed
+  bool await_ready(void) const noexcept { return _pool == nullptr; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    EventLoop *loop = &current_loop();
+    if (_pool->enqueue([this, loop, handle]() {
+          invoke();
+          loop->post([handle]() { handle.resume(); });
+        }))
+      return true;
+    // Not suspending resumes the coroutine at once, with the error
+    _exception = std::make_exception_ptr(
+        std::runtime_error("offload: the worker pool is stopping"));
+    return false;
+  }
+
+  Result await_resume(void) {
+    if (_pool == nullptr)
+      invoke();
+    if (_exception)
+      std::rethrow_exception(_exception);
+    if constexpr (!std::is_void_v<Result>)
+      return std::move(*_result);
+  }
+};
+
+/**
+ * @brief Run a function on a worker pool and resume with its result
+ *
+ * @param pool The pool to run on
+ * @param function The function; must not touch loop-owned state
+ * @return OffloadAwaiter<F> The awaitable
+ */
+template <typename F> OffloadAwaiter<F> offload(ThreadPool &pool, F function) {
+  return OffloadAwaiter<F>(&pool, std::move(function));
+}
+
+/**
+ * @brief Run a function on the server's worker pool
+ *
+ * Uses the pool of the calling thread's event loop (see
+ * ServerOptions::workerThreads); runs the function inline if there is
+ * none.
+ *
+ * @param function The function; must not touch loop-owned state
+ * @return OffloadAwaiter<F> The awaitable
+ */
+template <typename F> OffloadAwaiter<F> offload(F function) {
+  EventLoop *loop = EventLoop::current();
+  return OffloadAwaiter<F>(loop ? loop->workers() : nullptr,
+                           std::move(function));
+}
+
+/**
+ * @brief Reads the chunks of a BodyWriter from a coroutine
+ *
+ * Lets a coroutine consume a body produced elsewhere (another thread, an
+ * upstream connection) chunk by chunk: next() resumes with the next chunk
+ * as soon as the producer writes one, on the loop the coroutine waits on.
+ * Takes over the writer's resume callback, so the writer must not also be
+ * a response body.
+ */
+class ChunkReader {
+private:
+  struct State {
+    http::BodyWriter *source = nullptr;
+    std::atomic<EventLoop *> loop{nullptr}; ///< Read by the producer
+    std::coroutine_handle<> waiting;        ///< Loop thread only
+    std::optional<std::string> chunk;
+  };
+
+  std::shared_ptr<State> _state;
+
+  // Take a chunk, or report that the coroutine has to wait for one
+  static bool try_take(State &state);
+
+public:
+  /**
+   * @brief Awaitable returned by next()
+   */
+  class Awaiter {
+  private:
+    std::shared_ptr<State> _state;
+
+  public:
+    explicit Awaiter(std::shared_ptr<State> state)
+        : _state(std::move(state)) {}
+
+    bool await_ready(void);
+    void await_suspend(std::coroutine_handle<> handle);
+    std::optional<std::string> await_resume(void);
+  };
+
+  /**
+   * @brief Construct a reader for a writer
+   *
+   * @param source The writer; must outlive the reader
+   */
+  explicit ChunkReader(http::BodyWriter &source);
+
+  /**
+   * @brief Release the writer's resume callback
+   */
+  ~ChunkReader(void);
+
+  // Prevent copying (one reader per writer)
+  ChunkReader(const ChunkReader &) = delete;
+  ChunkReader &operator=(const ChunkReader &) = delete;
+
+  /**
+   * @brief Wait for the next chunk
+   *
+   * @return Awaiter Resumes with the chunk, or std::nullopt once the
+   * writer is ended and drained
+   */
+  Awaiter next(void) { return Awaiter(_state); }
+};
+
+namespace detail {
+template <typename T> struct SyncResult {
+  std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> value;
+  std::exception_ptr exception;
+};
+
+template <typename T>
+AsyncTask<void> run_to_completion(AsyncTask<T> task, SyncResult<T> &result,
+                                  EventLoop &loop) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+      result.value.emplace(true);
+    } else {
+      result.value.emplace(co_await std::move(task));
+    }
+  } catch (...) {
+    result.exception = std::current_exception();
+  }
+  loop.stop();
+}
+} // namespace detail
+
+/**
+ * @brief Run a task to completion on the calling thread
+ *
+ * Runs a private EventLoop until the task is done, so its awaitables work
+ * outside a server thread. Meant for tests and synchronous callers; it
+ * blocks the calling thread.
+ *
+ * @tparam T The task's result type
+ * @param task The task
+ * @return T The task's result
+ * @throws Whatever the task throws
+ */
+template <typename T> T sync_wait(AsyncTask<T> task) {
+  EventLoop loop;
+  detail::SyncResult<T> result;
+  // Started from inside run(), so the task's awaitables find the loop
+  loop.post([&]() {
+    detail::run_to_completion(std::move(task), result, loop).detach();
+  });
+  loop.run();
+  if (result.exception)
+    std::rethrow_exception(result.exception);
+  if constexpr (!std::is_void_v<T>)
+    return std::move(*result.value);
+}
+
+} // namespace fion::network
@@ -3,6 +3,7 @@
 #include "http/Request.hpp"
 #include "http/Response.hpp"
 #include "network/Buffer.hpp"
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -26,11 +27,50 @@ enum class ClientState {
  */
 class Client {
 private:
-  int _fd;                   ///< File descriptor for the client socket
-  Buffer _requestBuffer;     ///< Buffer for incoming request data
-  Buffer _responseBuffer;    ///< Buffer for outgoing response data
-  ClientState _state;        ///< Current connection state
-  mutable std::mutex _mutex; ///< Mutex for thread-safe operations
+  int _fd;                          ///< File descriptor for the client socket
+  Buffer _requestBuffer;            ///< Buffer for incoming request data
+  std::deque<http::Body> _outgoing; ///< Response parts waiting to be sent
+  std::size_t _outgoingOffset;      ///< Bytes of the front part already sent
+  bool _chunked; ///< Whether streamed chunks use chunked transfer coding
+  bool _waitingForStream; ///< Whether writing waits on a stream's producer
+  ClientState _state;               ///< Current connection state
+  mutable std::mutex _mutex;        ///< Mutex for thread-safe operations
+
+  /**
+   * @brief Send consecutive in-memory parts with a single gathered write
+   *
+   * @return ssize_t Number of bytes written, -1 on error (errno is set)
+   */
+  ssize_t send_contiguous();
+
+  /**
+   * @brief Send the file region at the front of the queue with sendfile(2)
+   *
+   * @param region The region to send
+   * @return ssize_t Number of bytes written, -1 on error (errno is set)
+   */
+  ssize_t send_file_region(const http::FileRegion &region);
+
+  /**
+   * @brief Queue a streamed chunk ahead of the part that produced it
+   *
+   * @param chunk The chunk, framed when chunked transfer coding is used
+   */
+  void queue_chunk(std::string chunk);
+
+  /**
+   * @brief Remove a finished generator or stream from the queue
+   *
+   * Queues the last-chunk marker when chunked transfer coding is used.
+   */
+  void finish_streamed_part();
+
+  /**
+   * @brief Drop sent bytes from the front of the outgoing queue
+   *
+   * @param len Number of bytes that were written to the socket
+   */
+  void consume_outgoing(std::size_t len);
 
 public:
   /**
@@ -61,7 +101,12 @@ public:
   ssize_t readRequest();
 
   /**
-   * @brief Write response data from the response buffer to the client socket
+   * @brief Write pending response data to the client socket
+   *
+   * Writes until everything is sent, the socket would block or a stream
+   * waits for its producer. In-memory parts are gathered into one
+   * sendmsg(2), file regions go through sendfile(2), and generators and
+   * streams are pulled one chunk at a time.
    *
    * @return ssize_t Number of bytes written, -1 on error
    */
@@ -70,10 +115,59 @@ public:
   /**
    * @brief Prepare response data from a Response object
    *
+   * Adds a Content-Length header when the body size is known and none was
+   * set. Bodies of unknown size are sent with Transfer-Encoding: chunked
+   * for HTTP/1.1 responses without Content-Length. The body is shared with
+   * the response, not copied, unless it is an owned string.
+   *
    * @param response The HTTP response to send
    */
   void prepare_response(const http::Response &response);
 
+  /**
+   * @brief Prepare response data from a Response object, taking its body
+   *
+   * @param response The HTTP response to send; its body is moved out
+   */
+  void prepare_response(http::Response &&response);
+
+  /**
+   * @brief Prepare response data from a Response object the caller keeps
+   *
+   * Only the body is taken. The headers, with any framing header added,
+   * are serialized and left in place so the caller can recycle them.
+   *
+   * @param response The HTTP response to send; its body is moved out
+   * @param framed Add no framing header even if the response has none
+   * (a HEAD answer whose GET body has no known length)
+   */
+  void take_response(http::Response &response, bool framed = false);
+
+  /**
+   * @brief Prepare an already serialized response
+   *
+   * @param response Status line, headers and body, sent as they are
+   */
+  void prepare_raw(http::SharedBuffer response);
+
+  /**
+   * @brief Check if response data is still waiting to be written
+   *
+   * @return true if writeResponse() has more to send
+   * @return false otherwise
+   */
+  bool has_pending_response() const { return !_outgoing.empty(); }
+
+  /**
+   * @brief Check if the last write stopped because a stream had no data
+   *
+   * Writing resumes through the stream's resume callback rather than a
+   * socket event in that case.
+   *
+   * @return true if the response waits on a stream producer
+   */
+  bool is_waiting_for_stream() const { return _waitingForStream; }
+
   /**
    * @brief Check if the request is complete and ready for processing
    *
@@ -122,9 +216,12 @@ public:
   void clear_request_buffer() { _requestBuffer.clear(); }
 
   /**
-   * @brief Clear the response buffer
+   * @brief Discard any response data not yet written
    */
-  void clear_response_buffer() { _responseBuffer.clear(); }
+  void clear_response_buffer() {
+    _outgoing.clear();
+    _outgoingOffset = 0;
+  }
 };
 
 } // namespace fion::network
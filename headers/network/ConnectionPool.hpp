@@ -4,6 +4,7 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace fion::network {
 /**
@@ -14,7 +15,8 @@ namespace fion::network {
  */
 class ConnectionPool {
 private:
-  std::unordered_map<int, std::unique_ptr<Client>> _clients;
+  // Shared so a request in flight on a worker keeps its client alive
+  std::unordered_map<int, std::shared_ptr<Client>> _clients;
   mutable std::mutex _mutex;
 
 public:
@@ -58,6 +60,24 @@ public:
    */
   Client *getClient(int fd);
 
+  /**
+   * @brief Get shared ownership of a client
+   *
+   * The client stays alive (and its socket open) while the returned
+   * pointer is held, even if it is removed from the pool meanwhile.
+   *
+   * @param fd The file descriptor of the client
+   * @return std::shared_ptr<Client> The client, or nullptr if not found
+   */
+  std::shared_ptr<Client> getSharedClient(int fd);
+
+  /**
+   * @brief Get the file descriptors of every client
+   *
+   * @return std::vector<int> The descriptors, in no particular order
+   */
+  std::vector<int> getClientFds() const;
+
   /**
    * @brief Get the number of active clients
    *
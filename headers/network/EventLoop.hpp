@@ -1,13 +1,19 @@
 #pragma once
 
 #include "network/Poller.hpp"
+#include "network/Task.hpp"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace fion::network {
-// Forward declaration
+// Forward declarations
 class ConnectionPool;
+class ThreadPool;
 
 /**
  * @brief Event callback function type
@@ -20,22 +26,89 @@ using EventCallback = std::function<void(int fd, uint32_t events)>;
  * @brief Event loop for processing I/O events
  *
  * This class runs an event loop that monitors file descriptors
- * using a Poller and dispatches events to registered callbacks.
+ * using a Poller and dispatches events to registered callbacks. Other
+ * threads hand work to the loop's thread with post().
  */
 class EventLoop {
 private:
   Poller _poller;
   std::atomic<bool> _running;
   EventCallback _event_callback;
+  int _wakeupFd;      ///< Polled for READ; an eventfd, or a pipe's read end
+  int _wakeupWriteFd; ///< Written by post(); same as _wakeupFd for eventfd
+
+  // Tasks posted from any thread: a lock-free stack that the loop takes
+  // whole and reverses, so producers never block each other or the loop
+  struct PostedTask {
+    Task task;
+    PostedTask *next = nullptr;
+  };
+  std::atomic<PostedTask *> _posted{nullptr};
+  std::atomic<unsigned> _posting{0}; ///< post() calls not returned yet
+
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    std::uint64_t sequence; ///< Keeps timers with one deadline in order
+    Task callback;
+  };
+  std::vector<Timer> _timers; ///< Min-heap on deadline; loop thread only
+  std::uint64_t _timerSequence = 0;
+  std::unordered_map<int, std::function<void(uint32_t)>>
+      _watchers; ///< One-shot fd watches; loop thread only
+  ThreadPool *_workers = nullptr;
+  std::chrono::steady_clock::time_point _polledAt;   ///< Loop thread only
+  std::chrono::steady_clock::time_point _readySince; ///< Loop thread only
+  std::chrono::microseconds _busyPoll{0}; ///< Spin budget; 0 never spins
+  unsigned _spinSkip = 0;    ///< Wakeups to block through before spinning
+  unsigned _spinSkipped = 0; ///< Of those, already blocked through
+  // Time spent waiting for events, in steady_clock ticks: finished waits,
+  // and the start of the current one (0 while not waiting)
+  std::atomic<std::int64_t> _idleTicks{0};
+  std::atomic<std::int64_t> _waitingSince{0};
+
+  /**
+   * @brief Make the wakeup descriptor readable
+   */
+  void wake();
+
+  /**
+   * @brief Run the tasks posted so far, on the loop's thread
+   */
+  void run_posted();
+
+  /**
+   * @brief Poll without blocking until events come or the budget is spent
+   *
+   * @return std::vector<PollerEventData> The events, or none if busy
+   * polling is off, skipped this time or found nothing
+   */
+  std::vector<PollerEventData> spin();
+
+  /**
+   * @brief Run the timers whose deadline has passed
+   */
+  void run_timers();
+
+  /**
+   * @brief Get how long the next poll may wait
+   *
+   * @return int Milliseconds until the next timer, or -1 to wait until
+   * an event or a wakeup
+   */
+  int poll_timeout() const;
 
 public:
   /**
    * @brief Construct a new Event Loop object
+   *
+   * @throws std::runtime_error if the wakeup descriptor cannot be created
    */
   EventLoop();
 
   /**
    * @brief Destroy the Event Loop object
+   *
+   * Waits for post() calls from other threads to return first.
    */
   ~EventLoop();
 
@@ -64,10 +137,107 @@ public:
    */
   void run();
 
+  /**
+   * @brief Run a task on the loop's thread
+   *
+   * Safe to call from any thread; wakes the loop if it is waiting for
+   * events. Tasks run in the order they were posted, between two rounds of
+   * I/O events, and once more when run() returns. Tasks posted after that
+   * are destroyed with the loop without running.
+   *
+   * @param task The task to run
+   */
+  void post(Task task);
+
+  /**
+   * @brief Run a callback once a delay has passed; loop thread only
+   *
+   * @param delay Time to wait
+   * @param callback Called on the loop's thread
+   */
+  void add_timer(std::chrono::milliseconds delay, Task callback);
+
+  /**
+   * @brief Call back once a descriptor is ready; loop thread only
+   *
+   * The descriptor is watched until its first event, then removed from
+   * the poller. It must not already be registered with this loop.
+   *
+   * @param fd The descriptor to watch
+   * @param events PollerEvent::READ and/or PollerEvent::WRITE
+   * @param callback Called on the loop's thread with the events that fired
+   * @throws std::runtime_error if the descriptor cannot be watched
+   */
+  void watch_fd(int fd, uint32_t events, std::function<void(uint32_t)> callback);
+
+  /**
+   * @brief Get the event loop running on the calling thread
+   *
+   * @return EventLoop* The loop whose run() is executing on this thread,
+   * or nullptr
+   */
+  static EventLoop *current();
+
+  /**
+   * @brief Set the worker pool that work from this loop is offloaded to
+   *
+   * @param workers The pool, or nullptr; must outlive the loop's use of it
+   */
+  void set_workers(ThreadPool *workers) { _workers = workers; }
+
+  /**
+   * @brief Get the worker pool work from this loop is offloaded to
+   *
+   * @return ThreadPool* The pool, or nullptr if there is none
+   */
+  ThreadPool *workers() const { return _workers; }
+
+  /**
+   * @brief Get the earliest time the events being dispatched may have
+   * become ready
+   *
+   * When poll() had to wait, the time it returned; when events were
+   * already pending, the start of the previous batch, as they may have
+   * arrived while it ran. The time since measures how long the loop kept
+   * an event waiting, erring long. Loop thread only.
+   *
+   * @return std::chrono::steady_clock::time_point The estimated time
+   */
+  std::chrono::steady_clock::time_point ready_since() const {
+    return _readySince;
+  }
+
+  /**
+   * @brief Spin before blocking for events, trading CPU for latency
+   *
+   * Before each blocking poll the loop polls without blocking for up to
+   * @p budget (cut short by the next timer). A spin that finds nothing
+   * makes the loop skip spinning on the next wakeups, twice as many each
+   * time up to 63, so an idle loop barely spins; an event that a spin
+   * would have caught brings spinning back on every wakeup. Set before
+   * run().
+   *
+   * @param budget Longest spin; 0 (the default) always blocks
+   */
+  void set_busy_poll(std::chrono::microseconds budget) { _busyPoll = budget; }
+
+  /**
+   * @brief Get the total time the loop spent waiting for events
+   *
+   * Blocking in poll() and spinning without finding events count, the
+   * wait in progress included. Sampled twice, it gives the loop's
+   * utilization over that period. Safe to call from any thread; close to
+   * the end of a wait, the result may be off by that wait.
+   *
+   * @return std::chrono::nanoseconds The idle time since construction
+   */
+  std::chrono::nanoseconds idle_time() const;
+
   /**
    * @brief Stop the event loop
    *
-   * Signals the event loop to stop after the current iteration.
+   * Safe to call from any thread; wakes the loop, which stops after the
+   * current iteration.
    */
   void stop();
 
@@ -60,6 +60,23 @@ public:
    */
   int acceptClient();
 
+  /**
+   * @brief Wait until a connection can be accepted
+   *
+   * @param timeoutMs Longest wait in milliseconds
+   * @return true if a connection is pending, false on timeout, error or
+   * shutdown
+   */
+  bool waitForClient(int timeoutMs);
+
+  /**
+   * @brief Stop accepting, waking a thread blocked in waitForClient()
+   *
+   * The socket stays open until close(), so it can be called while
+   * another thread still uses it.
+   */
+  void shutdown();
+
   /**
    * @brief Get the listening file descriptor
    *
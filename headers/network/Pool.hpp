@@ -1,10 +1,21 @@
 #pragma once
 
+#include "AsyncTask.hpp"
+#include "Bulkhead.hpp"
+#include "RouteCache.hpp"
 #include "Router.hpp"
+#include "network/AdmissionControl.hpp"
 #include "network/ConnectionPool.hpp"
 #include "network/EventLoop.hpp"
+#include "network/QueueDelayController.hpp"
+#include "network/ServerOptions.hpp"
+#include "network/ThreadPool.hpp"
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <thread>
+#include <utility>
 
 namespace fion::network {
 /**
@@ -12,6 +23,12 @@ namespace fion::network {
  *
  * This class encapsulates an EventLoop, ConnectionPool, and a worker thread.
  * Each pool handles I/O for its assigned clients independently.
+ *
+ * Routes with ExecutionMode::OFFLOAD run on a shared ThreadPool instead of
+ * the pool's thread. The worker posts the response back to the pool's
+ * EventLoop, which writes it; the client stays alive meanwhile even if the
+ * connection closes. AsyncHandler routes run as coroutines on the pool's
+ * own thread, which is never blocked while they wait.
  */
 class Pool {
 private:
@@ -19,6 +36,60 @@ private:
   ConnectionPool _connectionPool;
   std::thread _thread;
   Router *_router; ///< Pointer to the application's router
+  DispatchFunction _dispatch; ///< Used instead of the router when set
+  RouteCache _routeCache;     ///< Only touched by the pool's thread
+  ThreadPool *_workers; ///< Runs offloaded routes; nullptr runs them inline
+  ThreadPlacement _placement; ///< Applied by the pool's thread to itself
+  std::size_t _index;         ///< Position among the server's pools
+  std::size_t _routeCacheCapacity;
+  AdmissionControl *_admission; ///< Server-wide caps; nullptr for none
+  std::unique_ptr<QueueDelayController> _delay; ///< This loop's; null when
+                                                ///< disabled
+  std::atomic<std::size_t> _incoming{0}; ///< Added, not registered yet
+  std::atomic<std::size_t> _inFlight{0}; ///< Offloaded or async requests
+  int _socketBusyPoll; ///< SO_BUSY_POLL for clients, microseconds; 0 for none
+  // Recycled between requests, keeping their buffers (see PooledHandler)
+  std::unique_ptr<http::Request> _spareRequest;
+  std::unique_ptr<http::Response> _spareResponse;
+  TaskScope _async; ///< serve_async coroutines, cancelled when the loop ends
+
+  /**
+   * @brief Counts a request running off the read path while held
+   *
+   * Such a request refers to the pool (it posts its response to the loop)
+   * after its connection may be gone, so a retired pool is only destroyed
+   * once none is left. Move-only; empty when default-constructed.
+   */
+  class InFlight {
+  private:
+    Pool *_pool = nullptr;
+
+  public:
+    InFlight(void) = default;
+    explicit InFlight(Pool &pool) : _pool(&pool) {
+      _pool->_inFlight.fetch_add(1, std::memory_order_relaxed);
+    }
+    InFlight(InFlight &&other) noexcept
+        : _pool(std::exchange(other._pool, nullptr)) {}
+    InFlight &operator=(InFlight &&other) noexcept {
+      if (this != &other) {
+        release();
+        _pool = std::exchange(other._pool, nullptr);
+      }
+      return *this;
+    }
+    ~InFlight(void) { release(); }
+
+    // Prevent copying (one count per request)
+    InFlight(const InFlight &) = delete;
+    InFlight &operator=(const InFlight &) = delete;
+
+    void release(void) {
+      if (_pool)
+        std::exchange(_pool, nullptr)
+            ->_inFlight.fetch_sub(1, std::memory_order_release);
+    }
+  };
 
   /**
    * @brief Handle I/O events for a client
@@ -28,20 +99,164 @@ private:
    */
   void handle_client_event(int fd, uint32_t events);
 
+  /**
+   * @brief Set SO_BUSY_POLL (and SO_PREFER_BUSY_POLL) on a client socket
+   *
+   * Failures are logged and ignored.
+   *
+   * @param fd The client's file descriptor
+   */
+  void enable_busy_poll(int fd);
+
+  /**
+   * @brief Unregister and drop a client, releasing its admission
+   *
+   * @param fd The client's file descriptor
+   */
+  void close_client(int fd);
+
+  /**
+   * @brief Turn a request away because a cap is reached
+   *
+   * Prepares the pre-serialized 503, or nothing when the overload action
+   * is CLOSE, so flushing then closes the connection.
+   *
+   * @param client The client that sent the request
+   */
+  void reject_request(Client *client);
+
   /**
    * @brief Process a complete HTTP request
    *
    * @param client The client with a complete request
+   * @return true if the response is prepared, false if the route was
+   * offloaded and the response will be written once the worker is done
+   */
+  bool process_request(Client *client);
+
+  /**
+   * @brief Run a matched route on the worker pool
+   *
+   * @param client The client that sent the request
+   * @param target The matched route
+   * @param guard Keeps the route table holding target alive; released on
+   * this pool's thread once the response is written
+   * @param request The request, with its parameters set
+   * @param range The request's Range header, if any
+   * @param ifRange The request's If-Range header, if any
+   * @param permit The route's bulkhead slot, held until the handler is done
+   * @return true if queued, false if the worker pool is stopping and
+   * dropped the request
+   */
+  bool offload_request(Client *client, const Router::RouteTarget &target,
+                       EpochReclaimer::Guard guard,
+                       std::unique_ptr<http::Request> request,
+                       std::string range, std::string ifRange,
+                       Bulkhead::Permit permit);
+
+  /**
+   * @brief Run a matched AsyncHandler route as a coroutine
+   *
+   * Started detached from process_request(); writes the response once the
+   * handler finished. Coroutines still suspended when the loop stops are
+   * destroyed, releasing their client and everything else they hold.
+   *
+   * @param client The client that sent the request
+   * @param target The matched route
+   * @param guard Keeps the route table holding target alive; detached
+   * (see EpochReclaimer::detach), as it outlives the call
+   * @param request The request, with its parameters set
+   * @param range The request's Range header, if any
+   * @param ifRange The request's If-Range header, if any
+   * @param permit The route's bulkhead slot, held until the handler is done
+   */
+  AsyncTask<void> serve_async(std::shared_ptr<Client> client,
+                              const Router::RouteTarget &target,
+                              EpochReclaimer::Guard guard,
+                              std::unique_ptr<http::Request> request,
+                              std::string range, std::string ifRange,
+                              Bulkhead::Permit permit);
+
+  /**
+   * @brief Answer a request whose handler ran off the read path
+   *
+   * Used once an offloaded or asynchronous handler finished, on the pool's
+   * thread. Does nothing if the connection was closed meanwhile.
+   *
+   * @param client The client that sent the request
+   * @param method The request method
+   * @param range The request's Range header, if any
+   * @param ifRange The request's If-Range header, if any
+   * @param response The handler's response, or nullptr
+   * @param error The message of the exception the handler threw, if any
+   */
+  void complete_request(Client *client, http::Method method,
+                        const std::string &range, const std::string &ifRange,
+                        std::unique_ptr<http::Response> response,
+                        const std::string &error);
+
+  /**
+   * @brief Prepare the response of a routed request for writing
+   *
+   * Applies HEAD and Range handling, or answers 404 without a response.
+   *
+   * @param client The client to answer
+   * @param method The request method
+   * @param range The request's Range header, if any
+   * @param ifRange The request's If-Range header, if any
+   * @param response The handler's response, or nullptr
    */
-  void process_request(Client *client);
+  void finish_response(Client *client, http::Method method,
+                       const std::string &range, const std::string &ifRange,
+                       std::unique_ptr<http::Response> response);
+
+  /**
+   * @brief Write as much of the client's response as the socket accepts
+   *
+   * Closes the connection once the response is complete, or waits for a
+   * WRITE event when the socket buffer is full.
+   *
+   * @param client The client with a prepared response
+   */
+  void flush_response(Client *client);
+
+  /**
+   * @brief Resume writing a client's response when its stream gets data
+   *
+   * The producer may write from any thread; the write resumes on this
+   * pool's thread.
+   *
+   * @param client The client sending the streamed response
+   * @param writer The writer of the streamed body
+   */
+  void bind_stream(Client *client, http::BodyWriter &writer);
 
 public:
   /**
    * @brief Construct a new Pool object
    *
    * @param router Pointer to the application's router
+   * @param options Server options (route cache capacity)
+   * @param workers Worker pool for offloaded routes, or nullptr to run them
+   * inline; must outlive the pool's running loop
+   * @param index Position among the server's pools (picks the thread's CPU
+   * and name from options.ioPlacement)
+   * @param admission Server-wide caps, or nullptr; must outlive the pool
    */
-  explicit Pool(Router *router);
+  explicit Pool(Router *router, const ServerOptions &options = {},
+                ThreadPool *workers = nullptr, std::size_t index = 0,
+                AdmissionControl *admission = nullptr);
+
+  /**
+   * @brief Construct a new Pool object dispatching through a static table
+   *
+   * @param dispatch Function routing requests (e.g. RouteTable::dispatch)
+   * @param options Server options
+   * @param index Position among the server's pools
+   * @param admission Server-wide caps, or nullptr; must outlive the pool
+   */
+  explicit Pool(DispatchFunction dispatch, const ServerOptions &options = {},
+                std::size_t index = 0, AdmissionControl *admission = nullptr);
 
   /**
    * @brief Destroy the Pool object
@@ -58,6 +273,9 @@ public:
 
   /**
    * @brief Start the pool's event loop in a new thread
+   *
+   * The thread applies the placement and allocates the route cache and
+   * recycled objects itself before running the loop; returns once it has.
    */
   void run();
 
@@ -69,6 +287,9 @@ public:
   /**
    * @brief Add a new client to this pool
    *
+   * Safe to call from any thread: the client is created and registered on
+   * the pool's thread.
+   *
    * @param fd The file descriptor for the client socket
    */
   void addClient(int fd);
@@ -78,7 +299,68 @@ public:
    *
    * @return size_t The number of active clients
    */
-  size_t get_client_count() const { return _connectionPool.size(); }
+  size_t get_client_count() const {
+    return _connectionPool.size() + _incoming.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Check whether nothing refers to this pool any more
+   *
+   * True once it has no client and no offloaded or asynchronous request
+   * left; a pool no longer given clients can then be stopped and
+   * destroyed.
+   *
+   * @return true if the pool is drained
+   */
+  bool is_drained() const {
+    return _inFlight.load(std::memory_order_acquire) == 0 &&
+           get_client_count() == 0;
+  }
+
+  /**
+   * @brief Close every connection of this pool
+   *
+   * Safe to call from any thread; the connections are closed on the
+   * pool's thread. Requests running on workers finish, but their
+   * responses are dropped.
+   */
+  void close_all_clients();
+
+  /**
+   * @brief Get the position of this pool among the server's pools
+   *
+   * @return std::size_t The index its thread was placed with
+   */
+  std::size_t get_index() const { return _index; }
+
+  /**
+   * @brief Get the total time the pool's loop waited for events
+   *
+   * @return std::chrono::nanoseconds The idle time (see
+   * EventLoop::idle_time)
+   */
+  std::chrono::nanoseconds get_idle_time() const { return _loop.idle_time(); }
+
+  /**
+   * @brief Get the route cache counters of this pool
+   *
+   * @return RouteCache::Stats Hits, misses and occupancy
+   */
+  RouteCache::Stats get_route_cache_stats() const {
+    return _routeCache.stats();
+  }
+
+  /**
+   * @brief Get the state of this pool's queue delay controller
+   *
+   * @return std::optional<QueueDelayController::Stats> The state, or
+   * nothing if ServerOptions::queueDelayTarget is not set
+   */
+  std::optional<QueueDelayController::Stats> get_queue_delay_stats() const {
+    if (!_delay)
+      return std::nullopt;
+    return _delay->stats();
+  }
 };
 
 } // namespace fion::network
@@ -1,23 +1,98 @@
 #pragma once
 
 #include "network/Pool.hpp"
+#include "network/ServerOptions.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace fion::network {
+/**
+ * @brief Creates the pool with a given index, not yet running
+ */
+using PoolFactory = std::function<std::unique_ptr<Pool>(std::size_t index)>;
+
+/**
+ * @brief Pool counters of a server
+ */
+struct PoolStats {
+  std::size_t pools = 0;    ///< Pools given new connections
+  std::size_t draining = 0; ///< Retired pools still serving connections
+  double utilization = 0; ///< Average loop utilization at the last sample
+  std::uint64_t added = 0;   ///< Pools added by autoscaling
+  std::uint64_t retired = 0; ///< Pools retired by autoscaling and stopped
+};
+
 /**
  * @brief Manages multiple I/O pools and distributes clients among them
  *
  * This class coordinates multiple Pool instances, distributing new
  * client connections using a round-robin strategy.
+ *
+ * With autoscaling started, a thread samples the loops' utilization,
+ * adds pools through a factory and retires pools (see PoolScaling). A
+ * retired pool leaves the round-robin and is stopped and destroyed by that
+ * thread once drained; its connections are never moved to another pool.
  */
 class PoolManager {
 private:
+  // A retired pool, until it drained
+  struct Draining {
+    std::unique_ptr<Pool> pool;
+    std::chrono::steady_clock::time_point since;
+    bool closing = false; ///< Its connections were closed after the timeout
+  };
+
   std::vector<std::unique_ptr<Pool>> _pools;
-  mutable std::mutex _mutex;
+  std::vector<Draining> _draining;
+  mutable std::mutex _mutex; // Guards _pools, _draining and _nextPoolIndex
   size_t _nextPoolIndex;
 
+  PoolScaling _scaling;
+  PoolFactory _factory;
+  std::thread _scaler;
+  std::mutex _scalerMutex; // Guards _scalerStop
+  std::condition_variable _scalerWakeup;
+  bool _scalerStop = false;
+  std::atomic<double> _utilization{0};
+  std::atomic<std::uint64_t> _added{0};
+  std::atomic<std::uint64_t> _retired{0};
+
+  /**
+   * @brief Get the next pool in round-robin order; _mutex must be held
+   *
+   * @return Pool* The pool, or nullptr if there are none
+   */
+  Pool *next_pool();
+
+  /**
+   * @brief Autoscaling thread: samples, then adds or retires pools
+   */
+  void autoscale_loop();
+
+  /**
+   * @brief Create, start and add a pool with the lowest free index
+   */
+  void scale_up();
+
+  /**
+   * @brief Retire the pool with the fewest connections
+   */
+  void scale_down();
+
+  /**
+   * @brief Stop and destroy the retired pools that drained
+   *
+   * Closes the connections of those draining for longer than the timeout.
+   */
+  void reap_draining();
+
 public:
   /**
    * @brief Construct a new Pool Manager object
@@ -56,27 +131,85 @@ public:
   /**
    * @brief Distribute a client to the next available pool
    *
+   * Pools at @p maxPerPool clients are skipped, in round-robin order.
+   * The cap is approximate: a pool's count is read while its thread
+   * registers and closes connections, without waiting for it, so a client
+   * still being handed over may be missed and a pool end up a connection
+   * or two over the cap (or one be turned away just under it).
+   *
    * @param fd The file descriptor for the client socket
+   * @param maxPerPool Clients a pool may hold; 0 for no cap
+   * @return true if a pool took the client, false if all are full (the
+   * caller still owns fd)
+   * @throws std::runtime_error if there are no pools
    */
-  void distribute_client(int fd);
+  bool distribute_client(int fd, std::size_t maxPerPool = 0);
 
   /**
    * @brief Get the number of pools
    *
-   * @return size_t The number of pools managed
+   * @return size_t The number of pools given new connections
    */
   size_t pool_count() const {
     std::lock_guard<std::mutex> lock(_mutex);
     return _pools.size();
   }
 
+  /**
+   * @brief Visit every pool under the manager's lock, draining ones too
+   *
+   * @param visitor Called once per pool
+   */
+  void for_each_pool(const std::function<void(const Pool &)> &visitor) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &pool : _pools)
+      visitor(*pool);
+    for (const auto &draining : _draining)
+      visitor(*draining.pool);
+  }
+
   /**
    * @brief Start all pools
    */
   void start_all();
 
   /**
-   * @brief Stop all pools
+   * @brief Start adding and retiring pools with the load
+   *
+   * Does nothing unless scaling.maxPools is set. Pools added later are
+   * created with @p factory, at the lowest index no other pool uses.
+   *
+   * @param scaling Bounds, thresholds and sampling period
+   * @param factory Creates a pool, not yet running, for an index
+   * @throws std::invalid_argument if the bounds or thresholds are invalid
+   */
+  void start_autoscaling(const PoolScaling &scaling, PoolFactory factory);
+
+  /**
+   * @brief Check autoscaling bounds and thresholds
+   *
+   * @param scaling The settings; maxPools 0 (disabled) is always valid
+   * @throws std::invalid_argument if they are invalid
+   */
+  static void validate_scaling(const PoolScaling &scaling);
+
+  /**
+   * @brief Get the pool counters; safe to call from any thread
+   *
+   * @return PoolStats The current counters
+   */
+  PoolStats stats() const;
+
+  /**
+   * @brief Stop the autoscaling thread and wait for it
+   *
+   * No pool is added or retired afterwards, and the factory is no longer
+   * called. Safe to call more than once.
+   */
+  void stop_autoscaling();
+
+  /**
+   * @brief Stop autoscaling and all pools, draining ones included
    */
   void stop_all();
 };
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace fion::network {
+/**
+ * @brief Sheds work when requests keep waiting too long to be served
+ *
+ * A CoDel-style controller fed with queueing delays: how long a request
+ * waited between its connection becoming readable and its dispatch, and how
+ * long an offloaded request waited for a worker. A delay below the target
+ * shows the queue draining; until then requests may wait up to a whole
+ * interval, which absorbs bursts. Once delays stay above the target for
+ * longer than an interval, the queue is standing: the controller is
+ * overloaded and drops any request that waited more than the target, which
+ * keeps the queue short without a fixed cap.
+ *
+ * There is one per queue: each I/O pool has one for its loop, and the
+ * server one for the worker queue, so a standing queue only sheds the
+ * requests waiting in it. All state is atomic: the worker queue's is fed
+ * by every worker, and stats are read from any thread.
+ */
+class QueueDelayController {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Controller state, for metrics
+   */
+  struct Stats {
+    bool overloaded = false;    ///< Shedding at the short timeout
+    std::uint64_t observed = 0; ///< Delays measured
+    std::uint64_t shed = 0;     ///< Requests dropped
+    std::chrono::microseconds lastDelay{0}; ///< Most recent delay measured
+  };
+
+private:
+  const Clock::duration _target;
+  const Clock::duration _interval;
+  // Start of the current run of delays above the target, 0 if none
+  std::atomic<Clock::rep> _firstAbove{0};
+  std::atomic<Clock::rep> _lastAbove{0};
+  std::atomic<std::int64_t> _lastDelay{0}; ///< Nanoseconds
+  std::atomic<std::uint64_t> _observed{0};
+  std::atomic<std::uint64_t> _shed{0};
+
+  // Delays stayed above the target for an interval, until recently
+  bool overloaded(Clock::time_point now) const {
+    Clock::rep first = _firstAbove.load(std::memory_order_relaxed);
+    Clock::duration since = now.time_since_epoch();
+    return first != 0 && since - Clock::duration(first) > _interval &&
+           since - Clock::duration(_lastAbove.load(
+                       std::memory_order_relaxed)) <= _interval;
+  }
+
+public:
+  /**
+   * @brief Construct a new Queue Delay Controller object
+   *
+   * @param target Delay requests may keep waiting when overloaded (CoDel
+   * uses about 5 ms)
+   * @param interval How long delays may stay above the target before
+   * shedding, and the longest wait otherwise (about 100 ms)
+   */
+  QueueDelayController(std::chrono::milliseconds target,
+                       std::chrono::milliseconds interval);
+
+  // Prevent copying (shared by pointer)
+  QueueDelayController(const QueueDelayController &) = delete;
+  QueueDelayController &operator=(const QueueDelayController &) = delete;
+
+  /**
+   * @brief Record a request's queueing delay and decide on it
+   *
+   * @param delay How long the request waited
+   * @param now The current time
+   * @return true to serve the request, false to shed it
+   */
+  bool admit(Clock::duration delay, Clock::time_point now = Clock::now());
+
+  /**
+   * @brief Get the controller state; safe to call from any thread
+   *
+   * @return Stats The current state and counters
+   */
+  Stats stats(void) const;
+};
+} // namespace fion::network
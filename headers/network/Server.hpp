@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Router.hpp"
+#include "network/AdmissionControl.hpp"
 #include "network/Listener.hpp"
 #include "network/PoolManager.hpp"
+#include "network/ServerOptions.hpp"
+#include "network/ThreadPool.hpp"
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -21,6 +24,10 @@ private:
   Listener _listener;
   PoolManager _poolManager;
   Router *_router;
+  DispatchFunction _dispatch; ///< Used instead of the router when set
+  std::unique_ptr<ThreadPool> _workers; ///< Runs offloaded routes, if any
+  std::unique_ptr<AdmissionControl> _admission; ///< Set by start()
+  std::size_t _maxConnectionsPerPool = 0;
   std::atomic<bool> _running;
   std::thread _accept_thread;
 
@@ -37,6 +44,13 @@ public:
    */
   explicit Server(Router *router);
 
+  /**
+   * @brief Construct a new Server object dispatching through a static table
+   *
+   * @param dispatch Function routing requests (e.g. RouteTable::dispatch)
+   */
+  explicit Server(DispatchFunction dispatch);
+
   /**
    * @brief Destroy the Server object
    */
@@ -59,12 +73,26 @@ public:
    * @throws std::runtime_error if server startup fails
    */
   void start(const std::string &host, std::uint16_t port,
-             std::size_t numThreads = 4);
+             std::size_t numThreads = available_cpus());
+
+  /**
+   * @brief Start the server with explicit options
+   *
+   * @param host The hostname or IP address to bind to
+   * @param port The port number to listen on
+   * @param options Thread count and per-pool tuning
+   * @throws std::invalid_argument if a placement or the pool scaling is
+   * invalid
+   * @throws std::runtime_error if server startup fails
+   */
+  void start(const std::string &host, std::uint16_t port,
+             const ServerOptions &options);
 
   /**
    * @brief Stop the server
    *
-   * Stops accepting new connections and shuts down all I/O pools.
+   * Stops accepting new connections, lets offloaded requests finish and
+   * shuts down all I/O pools.
    */
   void stop();
 
@@ -75,6 +103,28 @@ public:
    * @return false otherwise
    */
   bool is_running() const { return _running.load(); }
+
+  /**
+   * @brief Sum the route cache counters of every pool
+   *
+   * @return RouteCache::Stats The aggregated counters
+   */
+  RouteCache::Stats get_route_cache_stats() const;
+
+  /**
+   * @brief Get the pool counters (pools, draining pools, utilization)
+   *
+   * @return PoolStats The counters; the pool count changes with
+   * ServerOptions::poolScaling
+   */
+  PoolStats get_pool_stats() const;
+
+  /**
+   * @brief Get the admission counters (open connections, rejections)
+   *
+   * @return AdmissionStats The counters; all zero before start()
+   */
+  AdmissionStats get_admission_stats() const;
 };
 
 } // namespace fion::network
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "network/ThreadPlacement.hpp"
+
+#include <chrono>
+#include <cstddef>
+
+namespace fion::network {
+/**
+ * @brief What the server does with work past one of its caps
+ */
+enum class OverloadAction {
+  REJECT, ///< Answer with a pre-serialized 503 and Retry-After, then close
+  CLOSE   ///< Close the connection without an answer
+};
+
+/**
+ * @brief Bounds and thresholds for adding and retiring I/O pools at runtime
+ *
+ * Every interval, the utilization of each loop (the share of the interval
+ * it was not waiting for events) is sampled and averaged over the pools.
+ * A pool is added when the average stays above scaleUpUtilization for
+ * samples intervals in a row, and one is retired when it stays below
+ * scaleDownUtilization, unless the pools left would then be above
+ * scaleUpUtilization. A retired pool gets no new connections and stops
+ * once its connections closed, or are closed after drainTimeout.
+ */
+struct PoolScaling {
+  std::size_t minPools = 1; ///< Pools kept however idle the server is
+  std::size_t maxPools = 0; ///< 0 disables autoscaling
+  double scaleUpUtilization = 0.75;
+  double scaleDownUtilization = 0.25;
+  std::chrono::milliseconds interval{1000}; ///< Between samples
+  unsigned samples = 5; ///< Intervals in a row before a change
+
+  /**
+   * @brief How long a retired pool's connections may stay open
+   *
+   * Past it, all of them are closed, including those waiting for a
+   * handler: the handler still finishes, but its response is dropped.
+   */
+  std::chrono::seconds drainTimeout{30};
+};
+
+/**
+ * @brief Tuning knobs for a Server and its I/O pools
+ */
+struct ServerOptions {
+  /**
+   * @brief Number of I/O threads (pools)
+   *
+   * Defaults to the CPUs the process can use, cgroup quota included (see
+   * available_cpus()). With autoscaling, the initial count, brought within
+   * poolScaling's bounds.
+   */
+  std::size_t numThreads = available_cpus();
+
+  /**
+   * @brief Add and retire I/O pools with the load
+   *
+   * Off by default. When on, the server starts numThreads pools, kept
+   * between minPools and maxPools.
+   */
+  PoolScaling poolScaling;
+
+  /**
+   * @brief Route matches cached per pool (see RouteCache)
+   *
+   * Worth enabling when a few paths receive most of the traffic; 0
+   * disables the cache.
+   */
+  std::size_t routeCacheCapacity = 0;
+
+  /**
+   * @brief Worker threads running routes with ExecutionMode::OFFLOAD
+   *
+   * Shared by all I/O pools. With 0, no worker pool is started and
+   * offloaded routes run inline like the others.
+   *
+   * Defaults to available_cpus() like numThreads, so with both defaults
+   * there are twice as many threads as CPUs. That suits the routes usually
+   * offloaded, which block (on files, locks, other services) more than
+   * they compute, while I/O threads only use a CPU when they have events.
+   * For CPU-bound offloaded work, split the CPUs instead: lower
+   * numThreads, set workerThreads to the CPUs left, and pin both groups
+   * (ioPlacement, workerPlacement) to disjoint cpus.
+   */
+  std::size_t workerThreads = available_cpus();
+
+  /**
+   * @brief Busy-polling budget of each I/O thread; 0 always blocks
+   *
+   * For latency-critical deployments: each loop spins for up to this long
+   * before blocking for events, backing off while idle (see
+   * EventLoop::set_busy_poll). Costs up to a core per I/O thread under
+   * load; best combined with pinned I/O threads.
+   */
+  std::chrono::microseconds busyPollBudget{0};
+
+  /**
+   * @brief SO_BUSY_POLL for client sockets, in microseconds; 0 leaves it
+   *
+   * Lets the kernel poll the NIC queue of a socket instead of waiting for
+   * its interrupt (Linux; SO_PREFER_BUSY_POLL is set too where
+   * available). Values above net.core.busy_read need CAP_NET_ADMIN.
+   */
+  std::chrono::microseconds socketBusyPoll{0};
+
+  /**
+   * @brief Affinity, scheduling and names of the I/O threads
+   *
+   * Each pool's thread applies it before allocating its loop-owned state,
+   * so with pinning that state lands on the thread's NUMA node.
+   */
+  ThreadPlacement ioPlacement{.name = "fion-io"};
+
+  /**
+   * @brief Affinity, scheduling and names of the worker threads
+   */
+  ThreadPlacement workerPlacement{.name = "fion-worker"};
+
+  /**
+   * @brief Connections open at once across the server; 0 for no cap
+   *
+   * Connections past the cap are turned away as soon as they are accepted.
+   */
+  std::size_t maxConnections = 0;
+
+  std::size_t maxConnectionsPerPool = 0; ///< Per I/O pool, approximate;
+                                         ///< 0 for no cap
+
+  /**
+   * @brief Offloaded requests waiting for a worker; 0 for no cap
+   *
+   * Past it, OFFLOAD routes are rejected instead of queued. Per-route caps
+   * are set with Route::maxInFlight.
+   */
+  std::size_t maxQueuedTasks = 0;
+
+  /**
+   * @brief Queueing delay tolerated under sustained load; 0 disables
+   *
+   * Enables adaptive shedding (see QueueDelayController): once requests
+   * keep waiting longer than this to be dispatched or to reach a worker,
+   * those that waited longer are rejected.
+   */
+  std::chrono::milliseconds queueDelayTarget{0};
+
+  /**
+   * @brief How long delays may stay above the target before shedding
+   */
+  std::chrono::milliseconds queueDelayInterval{100};
+
+  OverloadAction overloadAction = OverloadAction::REJECT;
+  std::chrono::seconds retryAfter{1}; ///< Retry-After of the 503
+};
+} // namespace fion::network
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fion::network {
+/**
+ * @brief Move-only unit of work for the ThreadPool
+ *
+ * Callables of up to INLINE_CAPACITY bytes (a lambda capturing a few
+ * pointers, a shared_ptr and a unique_ptr fits) are stored inside the task,
+ * so creating and running one does not allocate. Larger callables fall
+ * back to the heap.
+ */
+class Task {
+public:
+  /**
+   * @brief Bytes available for a callable stored inline
+   */
+  static constexpr std::size_t INLINE_CAPACITY = 48;
+
+private:
+  struct Ops {
+    void (*invoke)(void *storage);
+    void (*move)(void *destination, void *source); ///< Destroys the source
+    void (*destroy)(void *storage);
+  };
+
+  template <typename F>
+  static constexpr bool fits_inline =
+      sizeof(F) <= INLINE_CAPACITY && alignof(F) <= alignof(void *) &&
+      std::is_nothrow_move_constructible_v<F>;
+
+  template <typename F>
+  static constexpr Ops inline_ops{
+      [](void *storage) { (*static_cast<F *>(storage))(); },
+      [](void *destination, void *source) {
+        ::new (destination) F(std::move(*static_cast<F *>(source)));
+        static_cast<F *>(source)->~F();
+      },
+      [](void *storage) { static_cast<F *>(storage)->~F(); }};
+
+  template <typename F>
+  static constexpr Ops heap_ops{
+      [](void *storage) { (**static_cast<F **>(storage))(); },
+      [](void *destination, void *source) {
+        *static_cast<F **>(destination) = *static_cast<F **>(source);
+      },
+      [](void *storage) { delete *static_cast<F **>(storage); }};
+
+  alignas(void *) unsigned char _storage[INLINE_CAPACITY];
+  const Ops *_ops = nullptr;
+
+public:
+  Task(void) = default;
+
+  /**
+   * @brief Store a callable
+   *
+   * @tparam F A move-constructible type callable with no arguments
+   * @param callable The callable
+   */
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, Task> &&
+             std::is_invocable_v<std::decay_t<F> &>)
+  Task(F &&callable) {
+    using Stored = std::decay_t<F>;
+    if constexpr (fits_inline<Stored>) {
+      ::new (static_cast<void *>(_storage)) Stored(std::forward<F>(callable));
+      _ops = &inline_ops<Stored>;
+    } else {
+      *reinterpret_cast<Stored **>(_storage) =
+          new Stored(std::forward<F>(callable));
+      _ops = &heap_ops<Stored>;
+    }
+  }
+
+  Task(Task &&other) noexcept : _ops(other._ops) {
+    if (_ops)
+      _ops->move(_storage, other._storage);
+    other._ops = nullptr;
+  }
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other._ops)
+        other._ops->move(_storage, other._storage);
+      _ops = other._ops;
+      other._ops = nullptr;
+    }
+    return *this;
+  }
+
+  // Prevent copying (tasks run once and may own move-only state)
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task(void) { reset(); }
+
+  /**
+   * @brief Destroy the stored callable, if any
+   */
+  void reset(void) {
+    if (_ops)
+      _ops->destroy(_storage);
+    _ops = nullptr;
+  }
+
+  /**
+   * @brief Check whether a callable is stored
+   *
+   * @return true if the task can run
+   */
+  explicit operator bool(void) const { return _ops != nullptr; }
+
+  /**
+   * @brief Run the stored callable
+   */
+  void operator()(void) { _ops->invoke(_storage); }
+};
+
+} // namespace fion::network
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fion::network {
+/**
+ * @brief Scheduling policy applied to a server thread
+ */
+enum class SchedulingPolicy {
+  INHERIT,    ///< Keep the policy of the thread that started the server
+  OTHER,      ///< SCHED_OTHER, the default time-sharing policy
+  BATCH,      ///< SCHED_BATCH (Linux): throughput over latency
+  IDLE,       ///< SCHED_IDLE (Linux): only runs when nothing else does
+  FIFO,       ///< SCHED_FIFO real-time; usually needs CAP_SYS_NICE
+  ROUND_ROBIN ///< SCHED_RR real-time; usually needs CAP_SYS_NICE
+};
+
+/**
+ * @brief Where and how a group of server threads runs
+ *
+ * Applied by each thread to itself when it starts. Settings the system
+ * refuses (a real-time policy without privileges, affinity on macOS) are
+ * logged and skipped; the thread runs anyway.
+ */
+struct ThreadPlacement {
+  /**
+   * @brief Restrict the threads to CPUs
+   *
+   * With @ref cpus empty, every CPU the process may use, grouped by NUMA
+   * node, so consecutive threads share a node.
+   */
+  bool pin = false;
+
+  /**
+   * @brief CPUs the threads are pinned to
+   *
+   * Thread i gets cpus[i % cpus.size()] when @ref pinEach is set, or may
+   * run on any of them otherwise.
+   */
+  std::vector<int> cpus{};
+
+  bool pinEach = true; ///< One CPU per thread rather than the whole set
+
+  SchedulingPolicy policy = SchedulingPolicy::INHERIT;
+  int priority = 0; ///< Static priority for FIFO and ROUND_ROBIN (1-99)
+  std::optional<int> niceness{}; ///< Nice value (-20 to 19) for OTHER/BATCH
+
+  /**
+   * @brief Thread name prefix; threads are named "<name>-<index>"
+   *
+   * Shown by top, perf and debuggers; truncated to 15 bytes on Linux.
+   */
+  std::string name{};
+};
+
+/**
+ * @brief Apply a placement to the calling thread
+ *
+ * @param placement The placement
+ * @param index The thread's index in its group (picks its CPU and name)
+ */
+void apply_placement(const ThreadPlacement &placement, std::size_t index);
+
+/**
+ * @brief Check a placement before starting threads with it
+ *
+ * @param placement The placement
+ * @throws std::invalid_argument if a CPU is not available to the process
+ * or the priority does not suit the policy
+ */
+void validate_placement(const ThreadPlacement &placement);
+
+/**
+ * @brief Get the CPUs this process may run on
+ *
+ * @return std::vector<int> The CPU numbers, ascending
+ */
+std::vector<int> allowed_cpus(void);
+
+/**
+ * @brief Get the CPUs of a NUMA node that this process may run on
+ *
+ * @param node The node number
+ * @return std::vector<int> The CPU numbers, empty if the node does not
+ * exist or NUMA information is unavailable
+ */
+std::vector<int> numa_node_cpus(int node);
+
+/**
+ * @brief Get the number of CPUs the server can actually use
+ *
+ * The smaller of the CPUs in the affinity mask and the cgroup CPU quota
+ * (cgroup v2 cpu.max or v1 cfs_quota_us/cfs_period_us), rounded up, and at
+ * least 1. Computed once.
+ *
+ * @return std::size_t The number of usable CPUs
+ */
+std::size_t available_cpus(void);
+
+} // namespace fion::network
@@ -1,11 +1,20 @@
 #pragma once
 
+#include "network/Task.hpp"
+#include "network/ThreadPlacement.hpp"
+#include "network/WorkStealingDeque.hpp"
+
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <functional>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace fion::network {
@@ -14,21 +23,95 @@ namespace fion::network {
  *
  * This optional component offloads CPU-bound handler execution
  * to worker threads, preventing blocking of I/O threads.
+ *
+ * Each worker owns a WorkStealingDeque: tasks enqueued from a worker go to
+ * its own deque, tasks from other threads to a shared queue that workers
+ * drain in small batches, and idle workers steal from a random victim. A
+ * submission wakes at most one parked worker, and only when no worker is
+ * already searching for work; a searcher that finds some wakes the next
+ * one, so wakeups ramp up with the load instead of all at once.
+ *
+ * parallel_for, parallel_reduce and when_all split one request's CPU work
+ * across the workers. The calling thread takes part instead of only
+ * waiting: it runs the chunks of its own parallel_for, and a worker
+ * waiting in when_all runs queued tasks of its pool, so a fork-join
+ * started from a worker (or from a task it forked) cannot deadlock the
+ * pool. Other threads never run tasks they did not fork.
  */
 class ThreadPool {
 private:
-  std::vector<std::thread> _threads;
-  std::queue<std::function<void()>> _tasks;
-  mutable std::mutex _mutex; // mutable to allow locking in const methods
-  std::condition_variable _cv;
+  struct Worker {
+    WorkStealingDeque deque;
+    std::condition_variable wakeup; ///< Waited on with _idleMutex held
+    bool notified = false;          ///< Guarded by _idleMutex
+    std::uint64_t random = 0;       ///< Victim selection state
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> _workers;
+  ThreadPlacement _placement;
+
+  std::mutex _sharedMutex; // Guards _shared
+  std::deque<Task> _shared;
+  std::atomic<std::size_t> _sharedCount{0};
+
+  std::mutex _idleMutex; // Guards _idle and the workers' notified flags
+  std::vector<std::size_t> _idle;
+  std::atomic<std::size_t> _idleCount{0};
+  std::atomic<std::size_t> _searching{0};
   std::atomic<bool> _stop;
 
   /**
    * @brief Worker thread loop
    *
-   * Continuously fetches and executes tasks from the queue.
+   * Runs tasks from its own deque, then the shared queue, then other
+   * workers' deques, and parks when all are empty.
+   */
+  void worker_loop(std::size_t index);
+
+  Worker *current_worker(void) const;
+  // counted when the caller was already added to _searching (see notify)
+  bool find_task(Worker &self, Task &task, bool counted = false);
+  bool take_shared(Worker &self, Task &task);
+  bool steal(Worker &self, Task &task);
+  bool has_work(void) const;
+  // woken is set when a notifier woke the worker and counted it searching
+  bool park(std::size_t index, bool &woken);
+  void notify(std::size_t count);
+  bool push(Task task);
+
+  /**
+   * @brief Run chunks [0, chunks) on the calling thread and helper tasks
+   *
+   * Chunks are claimed one at a time from a shared counter, so a helper
+   * that never gets a worker costs nothing: the caller runs its chunks.
+   * Returns once every claimed chunk finished, rethrowing the first
+   * exception; chunks not yet started when one throws are skipped.
+   *
+   * @param chunks The number of chunks
+   * @param run Runs one chunk given its index
+   * @param context Passed to run; not used after this returns
+   */
+  void fork_join(std::size_t chunks, void (*run)(void *, std::size_t),
+                 void *context);
+
+  // Chunks of grain indexes in [begin, end), without overflowing for a
+  // grain close to SIZE_MAX
+  static std::size_t chunk_count(std::size_t begin, std::size_t end,
+                                 std::size_t grain) {
+    return (end - begin) / grain + ((end - begin) % grain != 0);
+  }
+
+  /**
+   * @brief Run one queued task on a worker of this pool
+   *
+   * Takes from the worker's own deque first, then from the shared queue,
+   * then steals.
+   *
+   * @param self The calling thread's worker
+   * @return true if a task ran
    */
-  void worker_loop();
+  bool run_pending_task(Worker &self);
 
 public:
   /**
@@ -38,10 +121,19 @@ public:
    */
   explicit ThreadPool(size_t numThreads);
 
+  /**
+   * @brief Construct a new Thread Pool object with placed workers
+   *
+   * @param numThreads The number of worker threads to create
+   * @param placement Affinity, scheduling and name prefix of the workers;
+   * worker i is placed as thread i of the group
+   */
+  ThreadPool(size_t numThreads, ThreadPlacement placement);
+
   /**
    * @brief Destroy the Thread Pool object
    *
-   * Stops all threads and waits for them to finish.
+   * Shuts the pool down first if that was not done yet.
    */
   ~ThreadPool();
 
@@ -53,44 +145,212 @@ public:
   ThreadPool(ThreadPool &&) = delete;
   ThreadPool &operator=(ThreadPool &&) = delete;
 
+  /**
+   * @brief Stop accepting tasks and wait for the queued ones
+   *
+   * Tasks submitted from other threads are dropped from now on; tasks the
+   * running ones enqueue still run. Returns once all of them finished and
+   * the workers exited. The pool stays valid, so threads still holding it
+   * can keep calling it. Safe to call more than once.
+   */
+  void shutdown();
+
   /**
    * @brief Enqueue a task for execution
    *
+   * Does not allocate when the callable and its arguments fit in a Task's
+   * inline storage. Dropped once the pool is stopping.
+   *
    * @tparam F The function type
    * @tparam Args The argument types
    * @param f The function to execute
    * @param args The arguments to pass to the function
+   * @return true if queued, false if the pool is stopping and the function
+   * was destroyed without running
    */
-  template <typename F, typename... Args> void enqueue(F &&f, Args &&...args) {
-    {
-      std::lock_guard<std::mutex> lock(_mutex);
-      if (_stop)
-        return;
-
-      _tasks.emplace([f = std::forward<F>(f),
-                      ... args = std::forward<Args>(args)]() mutable {
+  template <typename F, typename... Args> bool enqueue(F &&f, Args &&...args) {
+    if constexpr (sizeof...(Args) == 0) {
+      return push(Task(std::forward<F>(f)));
+    } else {
+      return push(Task([f = std::forward<F>(f),
+                        ... args = std::forward<Args>(args)]() mutable {
         f(std::forward<Args>(args)...);
-      });
+      }));
+    }
+  }
+
+  /**
+   * @brief Enqueue several tasks at once
+   *
+   * Takes the shared queue's lock once and wakes up to one worker per
+   * task.
+   *
+   * @param tasks The tasks; left empty
+   */
+  void enqueue_batch(std::vector<Task> &tasks);
+
+  /**
+   * @brief Enqueue a function and get a future for its result
+   *
+   * If the pool is stopping, the function is dropped and the future holds
+   * a broken_promise error.
+   *
+   * @tparam F A callable taking no arguments
+   * @param f The function to execute
+   * @return std::future The function's result or exception
+   */
+  template <typename F> auto submit(F &&f) {
+    using Result = std::invoke_result_t<std::decay_t<F> &>;
+    std::packaged_task<Result()> task(std::forward<F>(f));
+    auto future = task.get_future();
+    push(Task(std::move(task)));
+    return future;
+  }
+
+  /**
+   * @brief Run a function over [begin, end) split into chunks
+   *
+   * The range is cut into chunks of grain indexes (the last may be
+   * shorter) that the calling thread and the workers run in parallel.
+   * Blocks until all of them ran; an exception from a chunk is rethrown
+   * here.
+   *
+   * @tparam F Callable as f(chunkBegin, chunkEnd)
+   * @param begin First index
+   * @param end One past the last index
+   * @param grain Indexes per chunk; large enough that a chunk outweighs a
+   * task hand-off (tens of microseconds of work)
+   * @param f The function, called concurrently from several threads
+   */
+  template <typename F>
+  void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                    F &&f) {
+    if (begin >= end)
+      return;
+    grain = std::max<std::size_t>(grain, 1);
+    struct Range {
+      std::size_t begin, end, grain;
+      std::remove_reference_t<F> *f;
+    } range{begin, end, grain, &f};
+    fork_join(
+        chunk_count(begin, end, grain),
+        [](void *context, std::size_t chunk) {
+          auto &range = *static_cast<Range *>(context);
+          std::size_t from = range.begin + chunk * range.grain;
+          (*range.f)(from, from + std::min(range.grain, range.end - from));
+        },
+        &range);
+  }
+
+  /**
+   * @brief Reduce [begin, end) in parallel chunks
+   *
+   * Each chunk is mapped to a value by f; the values are then combined on
+   * the calling thread in chunk order, starting from identity, so the
+   * result does not depend on which thread ran which chunk.
+   *
+   * @tparam T The result type; copyable
+   * @tparam F Callable as f(chunkBegin, chunkEnd) returning a T
+   * @tparam Combine Callable as combine(T, T) returning a T
+   * @param begin First index
+   * @param end One past the last index
+   * @param grain Indexes per chunk (see parallel_for)
+   * @param identity Initial value, also the result of an empty range
+   * @param f Maps one chunk, called concurrently from several threads
+   * @param combine Folds the chunk values together
+   * @return T The combined value
+   */
+  template <typename T, typename F, typename Combine>
+  T parallel_reduce(std::size_t begin, std::size_t end, std::size_t grain,
+                    T identity, F &&f, Combine &&combine) {
+    if (begin >= end)
+      return identity;
+    grain = std::max<std::size_t>(grain, 1);
+    // Wrapped so that chunks never share a std::vector<bool> word
+    struct Slot {
+      T value;
+    };
+    std::vector<Slot> values(chunk_count(begin, end, grain), Slot{identity});
+    parallel_for(begin, end, grain, [&](std::size_t from, std::size_t to) {
+      values[(from - begin) / grain].value = f(from, to);
+    });
+    for (auto &slot : values)
+      identity = combine(std::move(identity), std::move(slot.value));
+    return identity;
+  }
+
+  /**
+   * @brief Wait for futures of tasks submitted to this pool
+   *
+   * A worker of this pool runs queued tasks while a future is not ready,
+   * so it still makes progress when every other worker is busy. Any other
+   * thread only blocks: the queued tasks are not its own.
+   *
+   * @tparam T The futures' value type
+   * @param futures The futures; all consumed
+   * @return std::vector<T> Their values in order (nothing for void); the
+   * first exception is rethrown after all of them finished
+   */
+  template <typename T> auto when_all(std::vector<std::future<T>> &futures) {
+    Worker *self = current_worker();
+    for (auto &future : futures) {
+      if (!self) {
+        future.wait();
+        continue;
+      }
+      while (future.wait_for(std::chrono::seconds(0)) !=
+             std::future_status::ready) {
+        // Nothing queued: the task runs elsewhere, but look again soon in
+        // case it forks work of its own
+        if (!run_pending_task(*self))
+          future.wait_for(std::chrono::milliseconds(1));
+      }
+    }
+    if constexpr (std::is_void_v<T>) {
+      std::exception_ptr error;
+      for (auto &future : futures) {
+        try {
+          future.get();
+        } catch (...) {
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+      futures.clear();
+      if (error)
+        std::rethrow_exception(error);
+    } else {
+      std::vector<T> values;
+      values.reserve(futures.size());
+      for (auto &future : futures)
+        values.push_back(future.get());
+      futures.clear();
+      return values;
     }
-    _cv.notify_one();
   }
 
+  /**
+   * @brief Get the pool the calling thread is a worker of
+   *
+   * Lets code running in an offloaded handler fork work onto its own pool.
+   *
+   * @return ThreadPool* The pool, or nullptr outside of any
+   */
+  static ThreadPool *current(void);
+
   /**
    * @brief Get the number of worker threads
    *
    * @return size_t The number of threads in the pool
    */
-  size_t thread_count() const { return _threads.size(); }
+  size_t thread_count() const { return _workers.size(); }
 
   /**
    * @brief Get the number of pending tasks
    *
-   * @return size_t The number of tasks in the queue
+   * @return size_t The number of queued tasks (approximate)
    */
-  size_t pending_tasks() const {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _tasks.size();
-  }
+  size_t pending_tasks() const;
 };
 
 } // namespace fion::network
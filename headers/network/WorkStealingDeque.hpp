@@ -0,0 +1,89 @@
+#pragma once
+
+#include "network/Task.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace fion::network {
+/**
+ * @brief Chase-Lev deque of tasks owned by one ThreadPool worker
+ *
+ * The owner pushes and pops at the bottom (LIFO, cache-warm) without
+ * locked instructions except when taking the last task; other workers
+ * steal from the top (FIFO) with one CAS. Tasks live in a fixed ring, so
+ * the deque never allocates after construction: push() fails when the ring
+ * is full and the caller falls back to the pool's shared queue.
+ *
+ * Each slot carries a sequence number so a task is only written once the
+ * thread that claimed the previous occupant has moved it out.
+ */
+class WorkStealingDeque {
+public:
+  /**
+   * @brief Number of slots in the ring
+   */
+  static constexpr std::size_t CAPACITY = 256;
+
+private:
+  static constexpr std::int64_t MASK = CAPACITY - 1;
+
+  struct alignas(64) Slot {
+    std::atomic<std::int64_t> sequence; ///< Free position, or position + 1
+                                        ///< once filled
+    Task task;
+  };
+
+  alignas(64) std::atomic<std::int64_t> _top{0};
+  alignas(64) std::atomic<std::int64_t> _bottom{0};
+  std::unique_ptr<Slot[]> _slots;
+
+  // Move the task at position out and free its slot for position next
+  void take(std::int64_t position, Task &out, std::int64_t next);
+
+public:
+  /**
+   * @brief Construct an empty deque
+   */
+  WorkStealingDeque(void);
+
+  // Prevent copying (shared between threads)
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  /**
+   * @brief Add a task at the bottom; owner thread only
+   *
+   * @param task The task; moved from only on success
+   * @return true if the task was added, false if the ring is full
+   */
+  bool push(Task &task);
+
+  /**
+   * @brief Take the most recently pushed task; owner thread only
+   *
+   * @param out Receives the task
+   * @return true if a task was taken
+   */
+  bool pop(Task &out);
+
+  /**
+   * @brief Take the oldest task; any thread
+   *
+   * @param out Receives the task
+   * @return true if a task was taken, false if the deque looked empty or
+   * another thread won the race for the task
+   */
+  bool steal(Task &out);
+
+  /**
+   * @brief Get the number of queued tasks (approximate)
+   *
+   * @return std::size_t The number of tasks
+   */
+  std::size_t size(void) const;
+};
+
+} // namespace fion::network
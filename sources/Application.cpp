@@ -26,6 +26,38 @@ void Application::addRoute(const std::string &pattern, const std::string &method
   router.addRoute(route);
 }
 
+void Application::addRoute(const std::string &pattern, const std::string &method,
+                           HandlerFunction handler,
+                           const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware,
+                           bool isRegex,
+                           const std::vector<std::string> &paramKeys) {
+  router.addRoute(Route(pattern, method, std::move(handler), middleware, isRegex, paramKeys));
+}
+
+void Application::addRoute(const Route &route) {
+  router.addRoute(route);
+}
+
+void Application::use(Middleware middleware) {
+  router.use(std::move(middleware));
+}
+
+void Application::useInterceptor(Interceptor interceptor) {
+  router.useInterceptor(std::move(interceptor));
+}
+
+void Application::useAfter(ResponseHook hook) {
+  router.useAfter(std::move(hook));
+}
+
+bool Application::removeRoute(const std::string &pattern, const std::string &method) {
+  return router.removeRoute(pattern, method);
+}
+
+void Application::replaceRoutes(const std::vector<Route> &routes) {
+  router.replaceRoutes(routes);
+}
+
 void Application::addGroup(const std::string &prefix, const std::vector<Route> &groupRoutes,
                            const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &groupMiddleware) {
   router.addGroup(prefix, groupRoutes, groupMiddleware);
@@ -37,15 +69,32 @@ void Application::addResource(const std::string &resource,
   router.addResource(resource, handler, middleware);
 }
 
+void Application::addStatic(const std::string &prefix, const std::string &directory,
+                            const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
+  router.addStatic(prefix, directory, middleware);
+}
+
+void Application::addBundle(const std::string &prefix, const std::string &bundlePath,
+                            const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
+  router.addBundle(prefix, bundlePath, middleware);
+}
+
 void Application::run(const std::string &host, std::uint16_t port,
                       std::size_t numThreads) {
+  network::ServerOptions options;
+  options.numThreads = numThreads;
+  run(host, port, options);
+}
+
+void Application::run(const std::string &host, std::uint16_t port,
+                      const network::ServerOptions &options) {
   // Initialize logging (log to stderr as well for foreground mode)
   logging::Logger::init("fion", LOG_USER, true);
   logging::Logger::info("Starting Fion server on " + host + ":" +
                         std::to_string(port) + " with " +
-                        std::to_string(numThreads) + " I/O threads");
+                        std::to_string(options.numThreads) + " I/O threads");
 
-  server->start(host, port, numThreads);
+  server->start(host, port, options);
 
   // Block until server is stopped (e.g., via stop() or signal)
   while (server->is_running()) {
@@ -0,0 +1,276 @@
+#include "AssetBundle.hpp"
+#include "logging/Logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fion {
+
+namespace {
+constexpr char kMagic[8] = {'F', 'I', 'O', 'N', 'P', 'A', 'C', 'K'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+constexpr std::size_t kDataAlignment = 16;
+
+struct PackHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint32_t entryCount;
+  std::uint32_t reserved;
+  std::uint64_t indexOffset;
+  std::uint64_t fileSize;
+};
+
+struct PackEntry {
+  std::uint64_t pathOffset;
+  std::uint64_t typeOffset;
+  std::uint64_t dataOffset;
+  std::uint64_t dataLength;
+  std::uint64_t hash;
+  std::uint32_t pathLength;
+  std::uint16_t typeLength;
+  std::uint16_t encoding;
+};
+
+std::size_t align_up(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Whether an Accept-Encoding value allows a coding (q=0 means refused)
+bool accepts(std::string_view header, std::string_view coding) {
+  while (!header.empty()) {
+    std::size_t comma = header.find(',');
+    std::string_view item = header.substr(0, comma);
+    header.remove_prefix(comma == std::string_view::npos ? header.size()
+                                                         : comma + 1);
+
+    std::size_t semi = item.find(';');
+    std::string_view name = item.substr(0, semi);
+    while (!name.empty() && name.front() == ' ')
+      name.remove_prefix(1);
+    while (!name.empty() && name.back() == ' ')
+      name.remove_suffix(1);
+    if (name != coding && name != "*")
+      continue;
+
+    std::string_view params =
+        semi == std::string_view::npos ? "" : item.substr(semi + 1);
+    std::size_t q = params.find("q=");
+    if (q == std::string_view::npos)
+      return true;
+    // q=0, q=0.0, ... refuse the coding; any other weight accepts it
+    std::string_view value = params.substr(q + 2);
+    value = value.substr(0, value.find_first_of(" ;"));
+    return value.find_first_of("123456789") != std::string_view::npos;
+  }
+  return false;
+}
+} // namespace
+
+AssetBundle::AssetBundle(const char *data, std::size_t size, std::string path)
+    : _data(data), _size(size), _index(nullptr), _entryCount(0),
+      _path(std::move(path)) {
+  PackHeader header;
+  std::memcpy(&header, _data, sizeof(header));
+  _index = _data + header.indexOffset;
+  _entryCount = header.entryCount;
+}
+
+AssetBundle::~AssetBundle(void) {
+  if (_data)
+    ::munmap(const_cast<char *>(_data), _size);
+}
+
+std::shared_ptr<const AssetBundle>
+AssetBundle::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open asset bundle " + path + ": " +
+                             std::string(std::strerror(errno)));
+
+  struct stat info {};
+  if (::fstat(fd, &info) < 0) {
+    ::close(fd);
+    throw std::runtime_error("Failed to stat asset bundle " + path + ": " +
+                             std::string(std::strerror(errno)));
+  }
+  auto size = static_cast<std::size_t>(info.st_size);
+  if (size < sizeof(PackHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Not an asset bundle: " + path);
+  }
+
+  void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // The mapping keeps the file referenced
+  if (mapping == MAP_FAILED)
+    throw std::runtime_error("Failed to map asset bundle " + path + ": " +
+                             std::string(std::strerror(errno)));
+
+  PackHeader header;
+  std::memcpy(&header, mapping, sizeof(header));
+  bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+               header.version == kVersion &&
+               header.byteOrder == kByteOrderMark &&
+               header.fileSize == size && header.indexOffset <= size &&
+               header.entryCount <=
+                   (size - header.indexOffset) / sizeof(PackEntry);
+  if (!valid) {
+    ::munmap(mapping, size);
+    throw std::runtime_error("Invalid or incompatible asset bundle: " + path);
+  }
+
+  logging::Logger::info("AssetBundle: mapped " + path + " (" +
+                        std::to_string(header.entryCount) + " entries, " +
+                        std::to_string(size) + " bytes)");
+  return std::shared_ptr<const AssetBundle>(
+      new AssetBundle(static_cast<const char *>(mapping), size, path));
+}
+
+void AssetBundle::write(const std::string &path, std::vector<Source> sources) {
+  struct Pending {
+    const Source *source;
+    AssetEncoding encoding;
+    const std::string *data;
+  };
+
+  std::sort(sources.begin(), sources.end(),
+            [](const Source &a, const Source &b) { return a.path < b.path; });
+  for (std::size_t i = 1; i < sources.size(); ++i) {
+    if (sources[i].path == sources[i - 1].path)
+      throw std::invalid_argument("Duplicate asset path: " + sources[i].path);
+  }
+
+  // Variants of one path stay adjacent, ordered by encoding
+  std::vector<Pending> pending;
+  for (const auto &source : sources) {
+    pending.push_back({&source, AssetEncoding::IDENTITY, &source.content});
+    if (source.gzip)
+      pending.push_back({&source, AssetEncoding::GZIP, &*source.gzip});
+    if (source.brotli)
+      pending.push_back({&source, AssetEncoding::BROTLI, &*source.brotli});
+  }
+
+  // Layout: header, index, strings, then aligned data blocks
+  std::size_t indexOffset = align_up(sizeof(PackHeader), alignof(PackEntry));
+  std::size_t stringsOffset = indexOffset + pending.size() * sizeof(PackEntry);
+  std::string strings;
+  std::vector<PackEntry> entries(pending.size());
+  for (std::size_t i = 0; i < pending.size(); ++i) {
+    const Source &source = *pending[i].source;
+    if (source.contentType.size() > UINT16_MAX)
+      throw std::invalid_argument("Content type too long: " + source.path);
+    entries[i].pathOffset = stringsOffset + strings.size();
+    entries[i].pathLength = static_cast<std::uint32_t>(source.path.size());
+    strings += source.path;
+    entries[i].typeOffset = stringsOffset + strings.size();
+    entries[i].typeLength =
+        static_cast<std::uint16_t>(source.contentType.size());
+    strings += source.contentType;
+    entries[i].encoding = static_cast<std::uint16_t>(pending[i].encoding);
+    entries[i].hash = hash(source.content);
+  }
+
+  std::size_t offset = align_up(stringsOffset + strings.size(), kDataAlignment);
+  for (std::size_t i = 0; i < pending.size(); ++i) {
+    entries[i].dataOffset = offset;
+    entries[i].dataLength = pending[i].data->size();
+    offset = align_up(offset + pending[i].data->size(), kDataAlignment);
+  }
+
+  PackHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrder = kByteOrderMark;
+  header.entryCount = static_cast<std::uint32_t>(entries.size());
+  header.indexOffset = indexOffset;
+  header.fileSize = offset;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::runtime_error("Failed to create asset bundle " + path);
+
+  auto pad_to = [&out](std::size_t position) {
+    static const char zeros[kDataAlignment] = {};
+    std::size_t current = static_cast<std::size_t>(out.tellp());
+    out.write(zeros, static_cast<std::streamsize>(position - current));
+  };
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  pad_to(indexOffset);
+  out.write(reinterpret_cast<const char *>(entries.data()),
+            static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+  out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+  for (std::size_t i = 0; i < pending.size(); ++i) {
+    pad_to(entries[i].dataOffset);
+    out.write(pending[i].data->data(),
+              static_cast<std::streamsize>(pending[i].data->size()));
+  }
+  pad_to(offset);
+  if (!out)
+    throw std::runtime_error("Failed to write asset bundle " + path);
+}
+
+std::optional<Asset> AssetBundle::find(std::string_view path,
+                                       std::string_view acceptEncoding) const {
+  auto entry_at = [this](std::size_t index) {
+    PackEntry entry;
+    std::memcpy(&entry, _index + index * sizeof(PackEntry), sizeof(entry));
+    return entry;
+  };
+  auto string_at = [this](std::uint64_t offset, std::uint64_t length) {
+    if (offset > _size || length > _size - offset)
+      return std::string_view();
+    return std::string_view(_data + offset, length);
+  };
+
+  // Lower bound on the path: the identity variant sorts first
+  std::size_t low = 0;
+  std::size_t high = _entryCount;
+  while (low < high) {
+    std::size_t mid = low + (high - low) / 2;
+    PackEntry entry = entry_at(mid);
+    if (string_at(entry.pathOffset, entry.pathLength) < path)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  std::optional<Asset> best;
+  for (std::size_t i = low; i < _entryCount; ++i) {
+    PackEntry entry = entry_at(i);
+    if (string_at(entry.pathOffset, entry.pathLength) != path)
+      break;
+    auto encoding = static_cast<AssetEncoding>(entry.encoding);
+    bool usable = encoding == AssetEncoding::IDENTITY ||
+                  (encoding == AssetEncoding::GZIP &&
+                   accepts(acceptEncoding, "gzip")) ||
+                  (encoding == AssetEncoding::BROTLI &&
+                   accepts(acceptEncoding, "br"));
+    if (!usable)
+      continue;
+    // Later variants compress better (br > gzip > identity)
+    best = Asset{string_at(entry.pathOffset, entry.pathLength),
+                 string_at(entry.typeOffset, entry.typeLength),
+                 string_at(entry.dataOffset, entry.dataLength), encoding,
+                 entry.hash};
+  }
+  return best;
+}
+
+std::uint64_t AssetBundle::hash(std::string_view data) {
+  std::uint64_t value = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    value ^= c;
+    value *= 1099511628211ULL;
+  }
+  return value;
+}
+
+} // namespace fion
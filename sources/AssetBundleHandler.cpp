@@ -0,0 +1,90 @@
+#include "AssetBundleHandler.hpp"
+#include "StaticFileHandler.hpp"
+#include "logging/Logger.hpp"
+
+#include <cstdio>
+
+namespace fion {
+
+namespace {
+const char *content_encoding(AssetEncoding encoding) {
+  switch (encoding) {
+  case AssetEncoding::GZIP:
+    return "gzip";
+  case AssetEncoding::BROTLI:
+    return "br";
+  default:
+    return nullptr;
+  }
+}
+} // namespace
+
+AssetBundleHandler::AssetBundleHandler(
+    std::string urlPrefix, std::shared_ptr<const AssetBundle> bundle,
+    std::string indexFile)
+    : _prefix(std::move(urlPrefix)), _bundle(std::move(bundle)),
+      _indexFile(std::move(indexFile)) {
+  if (!_bundle)
+    throw std::invalid_argument("AssetBundleHandler requires a bundle");
+  while (!_prefix.empty() && _prefix.back() == '/')
+    _prefix.pop_back();
+  logging::Logger::debug("AssetBundleHandler: serving " + _bundle->path() +
+                         " at " + (_prefix.empty() ? "/" : _prefix));
+}
+
+std::unique_ptr<http::Response>
+AssetBundleHandler::handle(std::unique_ptr<http::Request> request) {
+  auto response = std::make_unique<http::Response>();
+  const std::string path = request->getURL().getPathToResource();
+
+  std::string relative;
+  if (path.compare(0, _prefix.size(), _prefix) != 0 ||
+      (path.size() > _prefix.size() && path[_prefix.size()] != '/' &&
+       !_prefix.empty()) ||
+      !StaticFileHandler::decode_relative_path(path.substr(_prefix.size()),
+                                               relative)) {
+    response->setStatusCode(http::StatusCode::NOT_FOUND);
+    response->setBody("Not Found");
+    return response;
+  }
+  if (relative.empty() || relative.back() == '/')
+    relative += _indexFile;
+
+  const auto &headers = request->getHeaders();
+  auto asset = _bundle->find(relative, headers.get("Accept-Encoding", ""));
+  if (!asset) {
+    response->setStatusCode(http::StatusCode::NOT_FOUND);
+    response->setBody("Not Found");
+    return response;
+  }
+
+  // One tag per stored representation, derived from the identity hash
+  char etag[40];
+  const char *coding = content_encoding(asset->encoding);
+  std::snprintf(etag, sizeof(etag), "\"%016llx%s%s\"",
+                static_cast<unsigned long long>(asset->hash), coding ? "-" : "",
+                coding ? coding : "");
+  response->setHeader("ETag", etag);
+  response->setHeader("Vary", "Accept-Encoding");
+  response->setHeader("Accept-Ranges", "bytes");
+
+  std::string ifNoneMatch = headers.get("If-None-Match", "");
+  if (!ifNoneMatch.empty() &&
+      StaticFileHandler::etag_matches(ifNoneMatch, etag)) {
+    response->setStatusCode(http::StatusCode::NOT_MODIFIED);
+    return response;
+  }
+
+  response->setHeader("Content-Type", std::string(asset->contentType));
+  if (coding)
+    response->setHeader("Content-Encoding", coding);
+  if (request->getMethod() == http::Method::HEAD) {
+    response->setHeader("Content-Length", std::to_string(asset->data.size()));
+    return response;
+  }
+  // The bundle owns the mapping, so the body only holds a reference to it
+  response->setBody(http::SharedBuffer{_bundle, asset->data});
+  return response;
+}
+
+} // namespace fion
@@ -0,0 +1,145 @@
+#include "EpochReclaimer.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace fion {
+
+namespace {
+// Hands the calling thread's record back to the domain when the thread exits
+struct RecordOwner {
+  EpochReclaimer::ThreadRecord *record = nullptr;
+
+  ~RecordOwner(void) {
+    if (record == nullptr)
+      return;
+    record->nesting = 0;
+    // A detached guard hands its record back when released
+    EpochReclaimer::Guard(record, true).reset();
+  }
+};
+
+thread_local RecordOwner threadRecord;
+} // namespace
+
+void EpochReclaimer::Guard::reset(void) {
+  if (_record == nullptr)
+    return;
+  if (_detached) {
+    _record->epoch.store(0, std::memory_order_release);
+    EpochReclaimer::instance().release_record(_record);
+  } else if (--_record->nesting == 0)
+    _record->epoch.store(0, std::memory_order_release);
+  _record = nullptr;
+}
+
+EpochReclaimer::~EpochReclaimer(void) {
+  for (auto &retired : _retired)
+    retired.deleter();
+  ThreadRecord *record = _records.load();
+  while (record != nullptr) {
+    ThreadRecord *next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+EpochReclaimer &EpochReclaimer::instance(void) {
+  static EpochReclaimer domain;
+  return domain;
+}
+
+EpochReclaimer::ThreadRecord *EpochReclaimer::acquire_record(void) {
+  // Reuse a record released by an exited thread or a detached guard, if
+  // any, without walking the records in use
+  {
+    std::lock_guard<std::mutex> lock(_freeMutex);
+    if (!_free.empty()) {
+      ThreadRecord *record = _free.back();
+      _free.pop_back();
+      return record;
+    }
+  }
+
+  auto *record = new ThreadRecord();
+  record->next = _records.load(std::memory_order_relaxed);
+  while (!_records.compare_exchange_weak(record->next, record,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+  return record;
+}
+
+void EpochReclaimer::release_record(ThreadRecord *record) {
+  std::lock_guard<std::mutex> lock(_freeMutex);
+  _free.push_back(record);
+}
+
+EpochReclaimer::Guard EpochReclaimer::pin(void) {
+  ThreadRecord *record = threadRecord.record;
+  if (record == nullptr)
+    record = threadRecord.record = acquire_record();
+  // Sequentially consistent so the loads the caller makes next cannot be
+  // ordered before the pin becomes visible to retire()
+  if (record->nesting++ == 0)
+    record->epoch.store(_epoch.load());
+  return Guard(record);
+}
+
+EpochReclaimer::Guard EpochReclaimer::detach(Guard guard) {
+  if (!guard || guard._detached)
+    return guard;
+  // Pinned on the new record before the thread's pin is released, so the
+  // epoch is held throughout
+  ThreadRecord *record = acquire_record();
+  record->epoch.store(guard._record->epoch.load(std::memory_order_relaxed));
+  guard.reset();
+  return Guard(record, true);
+}
+
+std::uint64_t EpochReclaimer::oldest_pinned_epoch(void) const {
+  std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+  for (ThreadRecord *record = _records.load(std::memory_order_acquire);
+       record != nullptr; record = record->next) {
+    std::uint64_t epoch = record->epoch.load();
+    if (epoch != 0)
+      oldest = std::min(oldest, epoch);
+  }
+  return oldest;
+}
+
+void EpochReclaimer::retire(std::function<void()> deleter) {
+  // Readers pinned from now on see the epoch after this one, so they
+  // cannot hold the object
+  std::uint64_t epoch = _epoch.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(_retiredMutex);
+    _retired.push_back(Retired{epoch, std::move(deleter)});
+  }
+  reclaim();
+}
+
+std::size_t EpochReclaimer::reclaim(void) {
+  std::vector<Retired> ready;
+  {
+    std::lock_guard<std::mutex> lock(_retiredMutex);
+    std::uint64_t oldest = oldest_pinned_epoch();
+    auto keep = std::stable_partition(
+        _retired.begin(), _retired.end(),
+        [oldest](const Retired &retired) { return retired.epoch >= oldest; });
+    std::move(keep, _retired.end(), std::back_inserter(ready));
+    _retired.erase(keep, _retired.end());
+  }
+  // Deleters run unlocked; they may retire more objects
+  for (auto &retired : ready)
+    retired.deleter();
+  return ready.size();
+}
+
+std::size_t EpochReclaimer::pending(void) {
+  std::lock_guard<std::mutex> lock(_retiredMutex);
+  return _retired.size();
+}
+
+} // namespace fion
@@ -0,0 +1,126 @@
+#include "PatternMatcher.hpp"
+
+#include <cstring>
+
+namespace fion {
+
+namespace {
+constexpr std::string_view kDigitsGroup = "(\\d+)";
+constexpr std::string_view kSegmentGroup = "([^/]+)";
+constexpr std::string_view kRestGroup = "(.*)";
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+} // namespace
+
+PatternMatcher::PatternMatcher(std::string pattern, bool allowFastPath)
+    : _pattern(std::move(pattern)) {
+  if (!allowFastPath || !parse()) {
+    _tokens.clear();
+    _regex.emplace(_pattern);
+  }
+}
+
+bool PatternMatcher::parse(void) {
+  std::string_view rest(_pattern);
+  auto add_literal = [this](char c) {
+    if (_tokens.empty() || _tokens.back().kind != TokenKind::LITERAL)
+      _tokens.push_back({TokenKind::LITERAL, {}});
+    _tokens.back().literal.push_back(c);
+  };
+
+  while (!rest.empty()) {
+    char c = rest.front();
+    if (c == '\\') {
+      // Only escaped punctuation is a plain literal
+      if (rest.size() < 2 || !std::strchr("\\/.^$|?*+()[]{}-", rest[1]))
+        return false;
+      add_literal(rest[1]);
+      rest.remove_prefix(2);
+    } else if (c == '(') {
+      if (rest.substr(0, kDigitsGroup.size()) == kDigitsGroup) {
+        _tokens.push_back({TokenKind::DIGITS, {}});
+        rest.remove_prefix(kDigitsGroup.size());
+      } else if (rest.substr(0, kSegmentGroup.size()) == kSegmentGroup) {
+        _tokens.push_back({TokenKind::SEGMENT, {}});
+        rest.remove_prefix(kSegmentGroup.size());
+      } else if (rest.substr(0, kRestGroup.size()) == kRestGroup) {
+        _tokens.push_back({TokenKind::REST, {}});
+        rest.remove_prefix(kRestGroup.size());
+      } else {
+        return false;
+      }
+    } else if (std::strchr(".^$|?*+)[]{}", c)) {
+      return false;
+    } else {
+      add_literal(c);
+      rest.remove_prefix(1);
+    }
+  }
+
+  // Greedy scanning equals regex matching only if a group cannot eat the
+  // first byte of what follows it
+  for (std::size_t i = 0; i < _tokens.size(); ++i) {
+    TokenKind kind = _tokens[i].kind;
+    if (kind == TokenKind::LITERAL)
+      continue;
+    if (i + 1 == _tokens.size())
+      continue;
+    const Token &next = _tokens[i + 1];
+    if (kind == TokenKind::REST || next.kind != TokenKind::LITERAL)
+      return false;
+    char following = next.literal.front();
+    if (kind == TokenKind::DIGITS && is_digit(following))
+      return false;
+    if (kind == TokenKind::SEGMENT && following != '/')
+      return false;
+  }
+  return true;
+}
+
+bool PatternMatcher::match(std::string_view path, RouteParams &params) const {
+  params.count = 0;
+  if (_regex) {
+    std::cmatch match;
+    if (!std::regex_match(path.data(), path.data() + path.size(), match,
+                          *_regex))
+      return false;
+    for (std::size_t i = 1; i < match.size() && params.count < MAX_ROUTE_PARAMS;
+         ++i)
+      params.values[params.count++] = std::string_view(
+          match[i].first, static_cast<std::size_t>(match[i].length()));
+    return true;
+  }
+
+  std::size_t position = 0;
+  for (const Token &token : _tokens) {
+    std::size_t start = position;
+    switch (token.kind) {
+    case TokenKind::LITERAL:
+      if (path.compare(position, token.literal.size(), token.literal) != 0)
+        return false;
+      position += token.literal.size();
+      continue;
+    case TokenKind::DIGITS:
+      while (position < path.size() && is_digit(path[position]))
+        ++position;
+      break;
+    case TokenKind::SEGMENT:
+      while (position < path.size() && path[position] != '/')
+        ++position;
+      break;
+    case TokenKind::REST:
+      // '.' does not match line terminators
+      if (path.find_first_of("\r\n", position) != std::string_view::npos)
+        return false;
+      position = path.size();
+      break;
+    }
+    if (token.kind != TokenKind::REST && position == start)
+      return false;
+    if (params.count < MAX_ROUTE_PARAMS)
+      params.values[params.count++] = path.substr(start, position - start);
+  }
+  return position == path.size();
+}
+
+} // namespace fion
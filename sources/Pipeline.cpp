@@ -0,0 +1,72 @@
+#include "Pipeline.hpp"
+#include "AsyncHandler.hpp"
+
+namespace fion {
+
+Pipeline::Pipeline(std::shared_ptr<Handler> handler, HandlerFunction function,
+                   std::vector<Stage> stages, std::vector<ResponseHook> hooks)
+    : _function(std::move(function)), _handler(std::move(handler)),
+      _stages(std::move(stages)), _hooks(std::move(hooks)) {
+  if (!_function) {
+    _pooled = dynamic_cast<PooledHandler *>(_handler.get());
+    _async = dynamic_cast<AsyncHandler *>(_handler.get());
+  }
+}
+
+std::unique_ptr<http::Response>
+Pipeline::run_stages(std::unique_ptr<http::Request> &request) const {
+  for (const Stage &stage : _stages) {
+    if (!stage.interceptor) {
+      stage.middleware(request);
+    } else if (auto response = stage.interceptor(request)) {
+      return response;
+    }
+  }
+  return nullptr;
+}
+
+void Pipeline::run_hooks(http::Response *response) const {
+  if (response == nullptr)
+    return;
+  for (const ResponseHook &hook : _hooks)
+    hook(*response);
+}
+
+std::unique_ptr<http::Response>
+Pipeline::run(std::unique_ptr<http::Request> request) const {
+  std::unique_ptr<http::Response> response = run_stages(request);
+  if (!response) {
+    response = _function ? _function(std::move(request))
+                         : _handler->handle(std::move(request));
+  }
+  run_hooks(response.get());
+  return response;
+}
+
+std::unique_ptr<http::Response>
+Pipeline::run(std::unique_ptr<http::Request> &request,
+              std::unique_ptr<http::Response> &spare) const {
+  std::unique_ptr<http::Response> response = run_stages(request);
+  if (response) {
+    // Answered early
+  } else if (_pooled != nullptr) {
+    response = spare ? std::move(spare) : std::make_unique<http::Response>();
+    _pooled->serve(*request, *response);
+  } else {
+    response = _function ? _function(std::move(request))
+                         : _handler->handle(std::move(request));
+  }
+  run_hooks(response.get());
+  return response;
+}
+
+AsyncTask<std::unique_ptr<http::Response>>
+Pipeline::run_async(std::unique_ptr<http::Request> request) const {
+  std::unique_ptr<http::Response> response = run_stages(request);
+  if (!response)
+    response = co_await _async->handleAsync(std::move(request));
+  run_hooks(response.get());
+  co_return response;
+}
+
+} // namespace fion
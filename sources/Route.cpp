@@ -14,4 +14,11 @@ Route::Route(const std::string &pattern, const std::string &method,
              const std::vector<std::string> &paramKeys)
     : pathPattern(pattern), method(method), handler(handler), middleware(middleware), isRegex(isRegex), paramKeys(paramKeys) {}
 
+Route::Route(const std::string &pattern, const std::string &method,
+             HandlerFunction function,
+             const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware,
+             bool isRegex,
+             const std::vector<std::string> &paramKeys)
+    : pathPattern(pattern), method(method), function(std::move(function)), middleware(middleware), isRegex(isRegex), paramKeys(paramKeys) {}
+
 } // namespace fion
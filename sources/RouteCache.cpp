@@ -0,0 +1,114 @@
+#include "RouteCache.hpp"
+
+#include <functional>
+
+namespace fion {
+
+namespace {
+// Bump a counter owned by the calling thread without a locked instruction
+template <typename T> void bump(std::atomic<T> &counter, T delta = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + delta,
+                std::memory_order_relaxed);
+}
+} // namespace
+
+RouteCache::RouteCache(std::size_t capacity) { resize(capacity); }
+
+void RouteCache::resize(std::size_t capacity) {
+  std::vector<Entry>().swap(_entries);
+  _setMask = 0;
+  _size.store(0, std::memory_order_relaxed);
+  if (capacity == 0)
+    return;
+  std::size_t sets = 1;
+  while (sets * WAYS < capacity)
+    sets <<= 1;
+  _entries.resize(sets * WAYS);
+  _setMask = sets - 1;
+}
+
+bool RouteCache::match(const Router &router, http::Method method,
+                       std::string_view path, Router::RouteMatch &out) {
+  if (_entries.empty())
+    return router.match(method, path, out);
+
+  // Pin before reading the version: cached targets point into the table
+  // of that version, which stays alive while pinned
+  if (!out.guard)
+    out.guard = EpochReclaimer::instance().pin();
+  std::uint64_t version = router.version();
+  if (version != _version) {
+    clear();
+    _version = version;
+  }
+
+  std::uint64_t hash = std::hash<std::string_view>()(path) ^
+                       (static_cast<std::uint64_t>(method) * 0x9e3779b97f4a7c15ULL);
+  Entry *set = &_entries[(hash & _setMask) * WAYS];
+  for (std::size_t way = 0; way < WAYS; ++way) {
+    Entry &entry = set[way];
+    if (entry.lastUsed == 0 || entry.hash != hash || entry.method != method ||
+        entry.path != path)
+      continue;
+    entry.lastUsed = ++_tick;
+    out.target = entry.target;
+    out.params.count = entry.paramCount;
+    for (std::size_t i = 0; i < entry.paramCount; ++i)
+      out.params.values[i] =
+          path.substr(entry.params[i].first, entry.params[i].second);
+    bump(_hits);
+    return true;
+  }
+
+  bump(_misses);
+  if (!router.match(method, path, out))
+    return false;
+  if (out.normalizedPath.empty() && path.size() <= MAX_CACHED_PATH)
+    store(method, path, hash, out);
+  return true;
+}
+
+void RouteCache::store(http::Method method, std::string_view path,
+                       std::uint64_t hash, const Router::RouteMatch &match) {
+  // Replace an empty slot, otherwise the least recently used one
+  Entry *set = &_entries[(hash & _setMask) * WAYS];
+  Entry *victim = &set[0];
+  for (std::size_t way = 0; way < WAYS; ++way) {
+    if (set[way].lastUsed < victim->lastUsed)
+      victim = &set[way];
+  }
+  if (victim->lastUsed == 0)
+    bump(_size);
+
+  victim->hash = hash;
+  victim->lastUsed = ++_tick;
+  victim->method = method;
+  victim->path.assign(path); // Reuses the slot's buffer once warm
+  victim->target = match.target;
+  victim->paramCount = match.params.count;
+  for (std::size_t i = 0; i < match.params.count; ++i) {
+    std::string_view value = match.params.values[i];
+    victim->params[i] = {
+        static_cast<std::uint16_t>(value.data() - path.data()),
+        static_cast<std::uint16_t>(value.size())};
+  }
+}
+
+void RouteCache::clear(void) {
+  for (auto &entry : _entries) {
+    entry.lastUsed = 0;
+    entry.target = nullptr;
+  }
+  _size.store(0, std::memory_order_relaxed);
+}
+
+RouteCache::Stats RouteCache::stats(void) const {
+  Stats stats;
+  stats.hits = _hits.load(std::memory_order_relaxed);
+  stats.misses = _misses.load(std::memory_order_relaxed);
+  stats.entries = _size.load(std::memory_order_relaxed);
+  stats.capacity = _entries.size();
+  return stats;
+}
+
+} // namespace fion
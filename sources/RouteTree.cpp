@@ -0,0 +1,137 @@
+#include "RouteTree.hpp"
+
+#include <stdexcept>
+
+namespace fion {
+
+RouteTree::Node *RouteTree::insert_literal(Node *node, std::string_view bytes) {
+  while (!bytes.empty()) {
+    std::size_t index = node->indices.find(bytes.front());
+    if (index == std::string::npos) {
+      auto child = std::make_unique<Node>();
+      child->prefix = std::string(bytes);
+      node->indices.push_back(bytes.front());
+      node->children.push_back(std::move(child));
+      return node->children.back().get();
+    }
+
+    Node *child = node->children[index].get();
+    std::size_t common = 0;
+    while (common < child->prefix.size() && common < bytes.size() &&
+           child->prefix[common] == bytes[common])
+      ++common;
+
+    if (common < child->prefix.size()) {
+      // Split the edge: the shared bytes move to a new intermediate node
+      auto split = std::make_unique<Node>();
+      split->prefix = child->prefix.substr(0, common);
+      child->prefix.erase(0, common);
+      split->indices.push_back(child->prefix.front());
+      split->children.push_back(std::move(node->children[index]));
+      node->children[index] = std::move(split);
+      child = node->children[index].get();
+    }
+    bytes.remove_prefix(common);
+    node = child;
+  }
+  return node;
+}
+
+bool RouteTree::insert(std::string_view pattern, std::uint32_t route) {
+  Node *node = &_root;
+  std::size_t params = 0;
+  std::size_t literalStart = 0;
+  std::size_t position = 0;
+
+  while (position < pattern.size()) {
+    // position is at a '/'; look at the segment after it
+    std::size_t segmentStart = position + 1;
+    std::size_t segmentEnd = pattern.find('/', segmentStart);
+    if (segmentEnd == std::string_view::npos)
+      segmentEnd = pattern.size();
+
+    if (segmentStart < pattern.size() && pattern[segmentStart] == ':') {
+      if (++params > MAX_ROUTE_PARAMS)
+        throw std::invalid_argument("Too many parameters in route pattern: " +
+                                    std::string(pattern));
+      node = insert_literal(
+          node, pattern.substr(literalStart, segmentStart - literalStart));
+      if (!node->param)
+        node->param = std::make_unique<Node>();
+      node = node->param.get();
+      literalStart = segmentEnd;
+    }
+    position = segmentEnd;
+  }
+  node = insert_literal(node, pattern.substr(literalStart));
+
+  if (node->route != NO_ROUTE)
+    return false;
+  node->route = route;
+  ++_size;
+  return true;
+}
+
+std::uint32_t RouteTree::match_node(const Node &node, std::string_view rest,
+                                    RouteParams &params) {
+  if (rest.empty())
+    return node.route;
+
+  std::size_t index = node.indices.find(rest.front());
+  if (index != std::string::npos) {
+    const Node &child = *node.children[index];
+    if (rest.compare(0, child.prefix.size(), child.prefix) == 0) {
+      std::uint32_t route =
+          match_node(child, rest.substr(child.prefix.size()), params);
+      if (route != NO_ROUTE)
+        return route;
+    }
+  }
+
+  if (node.param) {
+    std::size_t end = rest.find('/');
+    std::string_view segment = rest.substr(0, end);
+    if (!segment.empty() && params.count < MAX_ROUTE_PARAMS) {
+      params.values[params.count++] = segment;
+      std::uint32_t route =
+          match_node(*node.param, rest.substr(segment.size()), params);
+      if (route != NO_ROUTE)
+        return route;
+      --params.count;
+    }
+  }
+  return NO_ROUTE;
+}
+
+std::uint32_t RouteTree::match(std::string_view path,
+                               RouteParams &params) const {
+  params.count = 0;
+  return match_node(_root, path, params);
+}
+
+bool RouteTree::is_normalized(std::string_view path) {
+  if (path.empty() || path.front() != '/')
+    return false;
+  if (path.size() > 1 && path.back() == '/')
+    return false;
+  return path.find("//") == std::string_view::npos;
+}
+
+std::string RouteTree::normalize(std::string_view path) {
+  std::string out = "/";
+  out.reserve(path.size() + 1);
+  for (char c : path) {
+    if (c == '/' && out.back() == '/')
+      continue;
+    out.push_back(c);
+  }
+  if (out.size() > 1 && out.back() == '/')
+    out.pop_back();
+  return out;
+}
+
+bool RouteTree::is_literal(std::string_view pattern) {
+  return pattern.find("/:") == std::string_view::npos;
+}
+
+} // namespace fion
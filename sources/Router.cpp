@@ -1,54 +1,335 @@
 
 #include "Router.hpp"
+#include "AssetBundleHandler.hpp"
+#include "StaticFileHandler.hpp"
 #include "logging/Logger.hpp"
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <map>
-#include <regex>
+#include <optional>
 #include <functional>
 
 namespace fion {
 
 
-void Router::addRoute(const Route &route) {
-  routes.push_back(route);
-  logging::Logger::debug("Router: added route pattern=" + route.pathPattern +
-                         " method=" + route.method);
+static_assert(MAX_ROUTE_PARAMS <= http::MAX_PATH_PARAMS,
+              "Requests must hold every route parameter");
+
+namespace {
+// Parameter names of a ":name" pattern, in order
+std::vector<std::string> patternKeys(std::string_view pattern) {
+  std::vector<std::string> keys;
+  for (std::size_t pos = pattern.find("/:"); pos != std::string_view::npos;
+       pos = pattern.find("/:", pos + 1)) {
+    std::size_t end = pattern.find('/', pos + 1);
+    keys.emplace_back(pattern.substr(pos + 2, end == std::string_view::npos
+                                                  ? std::string_view::npos
+                                                  : end - pos - 2));
+  }
+  return keys;
+}
+} // namespace
+
+Router::Router() : _current(new Snapshot()) {}
+
+Router::~Router() {
+  delete _current.load();
+  EpochReclaimer::instance().reclaim();
+}
+
+Router::Registration Router::prepare(Route route,
+                                     std::shared_ptr<const PatternMatcher> matcher) {
+  http::stringToMethod(route.method);
+  if (!route.handler && !route.function)
+    throw std::invalid_argument("Route " + route.pathPattern + " has no handler");
+  if (route.isRegex) {
+    // Compiled once when first registered, not on every request or update
+    if (!matcher)
+      matcher = std::make_shared<const PatternMatcher>(route.pathPattern);
+  } else if (patternKeys(RouteTree::normalize(route.pathPattern)).size() >
+             MAX_ROUTE_PARAMS) {
+    throw std::invalid_argument("Too many parameters in route pattern: " +
+                                route.pathPattern);
+  }
+  return Registration{std::move(route), std::move(matcher)};
+}
+
+std::size_t Router::update(const std::function<bool(Definition &)> &edit) {
+  std::lock_guard<std::recursive_mutex> lock(_writeMutex);
+  if (!_staged)
+    _pending = _current.load()->definition;
+  if (!edit(_pending))
+    return 0;
+  _staged = true;
+  if (_batchDepth > 0)
+    return 0; // Published once the batch ends
+  return settle();
+}
+
+std::size_t Router::settle() {
+  if (_live)
+    return flush();
+  if (_staged)
+    _unpublished.store(true, std::memory_order_release);
+  return 0;
+}
+
+std::size_t Router::flush() {
+  if (!_staged)
+    return 0;
+  _staged = false;
+  _unpublished.store(false, std::memory_order_relaxed);
+  return publish(std::move(_pending));
+}
+
+void Router::commit() {
+  std::lock_guard<std::recursive_mutex> lock(_writeMutex);
+  _live = true;
+  flush();
+}
+
+void Router::publishStaged() const {
+  // Publishing changes the router, not what it routes to
+  auto &self = const_cast<Router &>(*this);
+  std::lock_guard<std::recursive_mutex> lock(self._writeMutex);
+  // A batch in progress publishes when it ends
+  if (self._batchDepth == 0)
+    self.flush();
 }
 
+void Router::batch(const std::function<void()> &changes) {
+  std::lock_guard<std::recursive_mutex> lock(_writeMutex);
+  if (_batchDepth > 0) {
+    changes(); // Nested: part of the outer batch
+    return;
+  }
+  // Restored if changes() throws
+  std::optional<Definition> before;
+  if (_staged)
+    before = _pending;
+  ++_batchDepth;
+  try {
+    changes();
+  } catch (...) {
+    --_batchDepth;
+    if (before)
+      _pending = std::move(*before);
+    else
+      _staged = false;
+    throw;
+  }
+  --_batchDepth;
+  settle();
+}
+
+std::size_t Router::publish(Definition definition) {
+  const Snapshot *current = _current.load();
+
+  // Build the whole table before publishing it; anything thrown here
+  // leaves the current one untouched
+  auto next = std::make_unique<Snapshot>();
+  next->version = current->version + 1;
+  next->definition.stages = std::move(definition.stages);
+  next->definition.hooks = std::move(definition.hooks);
+  next->definition.routes.reserve(definition.routes.size());
+  std::size_t dropped = 0;
+  for (auto &registration : definition.routes) {
+    const Route &route = registration.route;
+    http::Method method = http::stringToMethod(route.method);
+    auto index = static_cast<std::uint32_t>(next->definition.routes.size());
+    MethodTable &table = next->tables[static_cast<std::size_t>(method)];
+
+    bool added = true;
+    if (route.isRegex) {
+      // Compiled by prepare()
+      table.regex.emplace_back(index, registration.matcher.get());
+    } else {
+      std::string pattern = RouteTree::normalize(route.pathPattern);
+      if (RouteTree::is_literal(pattern))
+        added = table.exact.emplace(pattern, index).second;
+      else
+        added = table.tree.insert(pattern, index);
+    }
+    if (!added) {
+      logging::Logger::warning("Router: duplicate route pattern=" + route.pathPattern +
+                               " method=" + route.method + " ignored");
+      ++dropped;
+      continue;
+    }
 
-// Helper: split path into segments
-static std::vector<std::string> splitPath(const std::string &path) {
-  std::vector<std::string> segments;
-  size_t start = 0, end = 0;
-  while ((end = path.find('/', start)) != std::string::npos) {
-    if (end > start) segments.push_back(path.substr(start, end - start));
-    start = end + 1;
+    // Compose the chain once here so requests only run it
+    std::vector<Pipeline::Stage> stages = next->definition.stages;
+    for (const auto &mw : route.middleware)
+      stages.push_back(Pipeline::Stage{mw, nullptr});
+    for (const auto &interceptor : route.interceptors)
+      stages.push_back(Pipeline::Stage{nullptr, interceptor});
+    std::vector<ResponseHook> hooks = route.responseHooks;
+    hooks.insert(hooks.end(), next->definition.hooks.begin(), next->definition.hooks.end());
+
+    // Shared with later snapshots, so requests admitted under this one
+    // still count against the cap
+    if (route.maxInFlight > 0 &&
+        (!registration.bulkhead ||
+         registration.bulkhead->limit() != route.maxInFlight))
+      registration.bulkhead = std::make_shared<Bulkhead>(route.maxInFlight);
+
+    // Function routes are called directly; the adapter only serves findRoute()
+    std::shared_ptr<Handler> handler = route.handler;
+    if (route.function)
+      handler = std::make_shared<FunctionHandler>(route.function);
+    next->targets.push_back(RouteTarget{
+        Pipeline(std::move(handler), route.function, std::move(stages), std::move(hooks)),
+        // Parameter names of tree routes come from the pattern itself
+        route.isRegex ? route.paramKeys : patternKeys(route.pathPattern),
+        route.execution, registration.bulkhead});
+    next->definition.routes.push_back(std::move(registration));
   }
-  if (start < path.size()) segments.push_back(path.substr(start));
-  return segments;
-}
-
-// Helper: match path with pattern and extract params
-static bool matchPattern(const std::string &pattern, const std::string &path,
-                        std::vector<std::string> &paramKeys,
-                        std::map<std::string, std::string> &params) {
-  auto patSegs = splitPath(pattern);
-  auto pathSegs = splitPath(path);
-  if (patSegs.size() != pathSegs.size()) return false;
-  for (size_t i = 0; i < patSegs.size(); ++i) {
-    if (!patSegs[i].empty() && patSegs[i][0] == ':') {
-      std::string key = patSegs[i].substr(1);
-      paramKeys.push_back(key);
-      params[key] = pathSegs[i];
-    } else if (patSegs[i] != pathSegs[i]) {
+
+  // Readers pin before loading _current, so once the old snapshot is
+  // unpublished only those already holding it can reach it
+  _current.store(next.release());
+  _version.store(current->version + 1);
+  EpochReclaimer::instance().retire([current] { delete current; });
+  return dropped;
+}
+
+void Router::addRoute(const Route &route) {
+  Registration registration = prepare(route);
+  std::size_t dropped = update([&](Definition &definition) {
+    definition.routes.push_back(std::move(registration));
+    return true;
+  });
+  if (dropped == 0)
+    logging::Logger::debug("Router: added route pattern=" + route.pathPattern +
+                           " method=" + route.method);
+}
+
+void Router::use(Middleware middleware) {
+  update([&](Definition &definition) {
+    definition.stages.push_back(Pipeline::Stage{std::move(middleware), nullptr});
+    return true;
+  });
+}
+
+void Router::useInterceptor(Interceptor interceptor) {
+  update([&](Definition &definition) {
+    definition.stages.push_back(Pipeline::Stage{nullptr, std::move(interceptor)});
+    return true;
+  });
+}
+
+void Router::useAfter(ResponseHook hook) {
+  update([&](Definition &definition) {
+    definition.hooks.push_back(std::move(hook));
+    return true;
+  });
+}
+
+bool Router::removeRoute(const std::string &pattern, const std::string &method) {
+  bool removed = false;
+  update([&](Definition &definition) {
+    auto &routes = definition.routes;
+    auto it = std::find_if(routes.begin(), routes.end(), [&](const Registration &r) {
+      return r.route.pathPattern == pattern && r.route.method == method;
+    });
+    if (it == routes.end())
       return false;
+    routes.erase(it);
+    removed = true;
+    return true;
+  });
+  if (removed)
+    logging::Logger::debug("Router: removed route pattern=" + pattern +
+                           " method=" + method);
+  return removed;
+}
+
+void Router::replaceRoutes(const std::vector<Route> &routes) {
+  update([&](Definition &definition) {
+    const std::vector<Registration> &current = definition.routes;
+    std::vector<Registration> next;
+    next.reserve(routes.size());
+    for (const auto &route : routes) {
+      // Keep the compiled regex of routes that stay
+      std::shared_ptr<const PatternMatcher> matcher;
+      if (route.isRegex) {
+        for (const auto &registration : current) {
+          if (registration.matcher && registration.route.pathPattern == route.pathPattern) {
+            matcher = registration.matcher;
+            break;
+          }
+        }
+      }
+      next.push_back(prepare(route, std::move(matcher)));
+    }
+    definition.routes = std::move(next);
+    return true;
+  });
+  logging::Logger::debug("Router: replaced routes count=" + std::to_string(routes.size()));
+}
+
+std::vector<Route> Router::getRoutes() const {
+  if (_unpublished.load(std::memory_order_acquire))
+    publishStaged();
+  EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+  const Snapshot *snapshot = _current.load();
+  std::vector<Route> routes;
+  routes.reserve(snapshot->definition.routes.size());
+  for (const auto &registration : snapshot->definition.routes)
+    routes.push_back(registration.route);
+  return routes;
+}
+
+bool Router::matchMethod(const Snapshot &snapshot, http::Method method,
+                         std::string_view path, std::string_view normalized,
+                         RouteMatch &out) {
+  const MethodTable &table = snapshot.tables[static_cast<std::size_t>(method)];
+  out.params.count = 0;
+
+  auto exact = table.exact.find(normalized);
+  if (exact != table.exact.end()) {
+    out.target = &snapshot.targets[exact->second];
+    return true;
+  }
+
+  std::uint32_t index = table.tree.match(normalized, out.params);
+  if (index != RouteTree::NO_ROUTE) {
+    out.target = &snapshot.targets[index];
+    return true;
+  }
+
+  for (const auto &[regexIndex, matcher] : table.regex) {
+    if (matcher->match(path, out.params)) {
+      out.target = &snapshot.targets[regexIndex];
+      return true;
     }
   }
-  return true;
+  out.params.count = 0;
+  return false;
 }
 
-#include <regex>
+bool Router::match(http::Method method, std::string_view path, RouteMatch &out) const {
+  out.target = nullptr;
+  if (_unpublished.load(std::memory_order_acquire))
+    publishStaged();
+  if (!out.guard)
+    out.guard = EpochReclaimer::instance().pin();
+  const Snapshot &snapshot = *_current.load();
+
+  std::string_view normalized = path;
+  if (!RouteTree::is_normalized(path)) {
+    out.normalizedPath = RouteTree::normalize(path);
+    normalized = out.normalizedPath;
+  }
+
+  if (matchMethod(snapshot, method, path, normalized, out))
+    return true;
+  if (method == http::Method::HEAD)
+    return matchMethod(snapshot, http::Method::GET, path, normalized, out);
+  return false;
+}
 
 std::shared_ptr<Handler> Router::findRoute(const std::string &path,
                                            const std::string &method,
@@ -56,55 +337,96 @@ std::shared_ptr<Handler> Router::findRoute(const std::string &path,
                                            std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &outMiddleware) {
   logging::Logger::debug("Router: searching for route path=" + path +
                          " method=" + method);
-  for (const auto &route : routes) {
-    if (route.method != method) continue;
-    if (route.isRegex) {
-      std::smatch match;
-      std::regex re(route.pathPattern);
-      if (std::regex_match(path, match, re)) {
-        // Extract named groups if any
-        for (size_t i = 1; i < match.size(); ++i) {
-          if (i-1 < route.paramKeys.size())
-            outParams[route.paramKeys[i-1]] = match[i];
-        }
-        outMiddleware = route.middleware;
-        logging::Logger::debug("Router: regex route matched");
-        return route.handler;
-      }
-    } else {
-      std::vector<std::string> paramKeys;
-      std::map<std::string, std::string> params;
-      if (matchPattern(route.pathPattern, path, paramKeys, params)) {
-        outParams = params;
-        outMiddleware = route.middleware;
-        logging::Logger::debug("Router: param route matched");
-        return route.handler;
-      }
+  RouteMatch found;
+  try {
+    if (!match(http::stringToMethod(method), path, found)) {
+      logging::Logger::debug("Router: no matching route");
+      return nullptr;
     }
+  } catch (const std::invalid_argument &) {
+    return nullptr;
   }
-  logging::Logger::debug("Router: no matching route");
-  return nullptr;
+
+  const RouteTarget &target = *found.target;
+  const auto &keys = target.paramKeys;
+  for (std::size_t i = 0; i < found.params.count && i < keys.size(); ++i)
+    outParams[keys[i]] = std::string(found.params.values[i]);
+  outMiddleware.clear();
+  for (const auto &stage : target.pipeline.stages()) {
+    if (stage.middleware)
+      outMiddleware.push_back(stage.middleware);
+  }
+  return target.pipeline.handler();
 }
 
 // Grouping and RESTful helpers (stubs)
 void Router::addGroup(const std::string &prefix, const std::vector<Route> &groupRoutes,
                       const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &groupMiddleware) {
+  std::vector<Registration> registrations;
+  registrations.reserve(groupRoutes.size());
   for (auto route : groupRoutes) {
     route.pathPattern = prefix + route.pathPattern;
-    for (const auto &mw : groupMiddleware) route.middleware.push_back(mw);
-    addRoute(route);
+    route.middleware.insert(route.middleware.begin(), groupMiddleware.begin(),
+                            groupMiddleware.end());
+    registrations.push_back(prepare(std::move(route)));
   }
+  // Published as one change, so requests never see half a group
+  update([&](Definition &definition) {
+    for (auto &registration : registrations)
+      definition.routes.push_back(std::move(registration));
+    return true;
+  });
+  logging::Logger::debug("Router: added group prefix=" + prefix +
+                         " count=" + std::to_string(groupRoutes.size()));
 }
 
 void Router::addResource(const std::string &resource,
                          std::shared_ptr<Handler> handler,
                          const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
   // RESTful: GET /resource, POST /resource, GET /resource/:id, PUT /resource/:id, DELETE /resource/:id
-  addRoute(Route("/" + resource, "GET", handler, middleware));
-  addRoute(Route("/" + resource, "POST", handler, middleware));
-  addRoute(Route("/" + resource + "/:id", "GET", handler, middleware));
-  addRoute(Route("/" + resource + "/:id", "PUT", handler, middleware));
-  addRoute(Route("/" + resource + "/:id", "DELETE", handler, middleware));
+  addGroup("/" + resource, {Route("", "GET", handler),
+                            Route("", "POST", handler),
+                            Route("/:id", "GET", handler),
+                            Route("/:id", "PUT", handler),
+                            Route("/:id", "DELETE", handler)},
+           middleware);
+}
+
+void Router::addStatic(const std::string &prefix, const std::string &directory,
+                       const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
+  auto handler = std::make_shared<StaticFileHandler>(prefix, directory);
+  addPrefixRoutes(prefix, handler, middleware);
+}
+
+void Router::addBundle(const std::string &prefix, const std::string &bundlePath,
+                       const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
+  auto handler = std::make_shared<AssetBundleHandler>(prefix, AssetBundle::open(bundlePath));
+  addPrefixRoutes(prefix, handler, middleware);
+}
+
+void Router::addPrefixRoutes(const std::string &prefix, std::shared_ptr<Handler> handler,
+                             const std::vector<std::function<void(std::unique_ptr<http::Request>&)>> &middleware) {
+  // Escape the prefix so it matches literally inside the regex route
+  std::string pattern;
+  for (char c : prefix) {
+    if (std::string("\\^$.|?*+()[]{}").find(c) != std::string::npos)
+      pattern += '\\';
+    pattern += c;
+  }
+  while (!pattern.empty() && pattern.back() == '/') pattern.pop_back();
+  // Two simple patterns instead of "prefix(/.*)?" so both take the
+  // PatternMatcher fast path
+  std::vector<Registration> registrations;
+  for (const char *method : {"GET", "HEAD"}) {
+    registrations.push_back(prepare(Route(pattern, method, handler, middleware, true)));
+    registrations.push_back(prepare(
+        Route(pattern + "/(.*)", method, handler, middleware, true, {"path"})));
+  }
+  update([&](Definition &definition) {
+    for (auto &registration : registrations)
+      definition.routes.push_back(std::move(registration));
+    return true;
+  });
 }
 
 } // namespace fion
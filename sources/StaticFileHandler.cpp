@@ -0,0 +1,469 @@
+#include "StaticFileHandler.hpp"
+#include "logging/Logger.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef __APPLE__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace fion {
+
+namespace {
+int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+} // namespace
+
+bool StaticFileHandler::decode_relative_path(const std::string &raw,
+                                             std::string &out) {
+  out.clear();
+  out.reserve(raw.size());
+  for (std::size_t i = 0; i < raw.size(); ++i) {
+    char c = raw[i];
+    if (c == '%') {
+      if (i + 2 >= raw.size())
+        return false;
+      int high = hex_value(raw[i + 1]);
+      int low = hex_value(raw[i + 2]);
+      if (high < 0 || low < 0)
+        return false;
+      c = static_cast<char>(high * 16 + low);
+      i += 2;
+    }
+    if (c == '\0' || c == '\\')
+      return false;
+    out.push_back(c);
+  }
+
+  // Reject "." and ".." segments
+  std::size_t start = 0;
+  while (start <= out.size()) {
+    std::size_t end = out.find('/', start);
+    if (end == std::string::npos)
+      end = out.size();
+    std::string_view segment(out.data() + start, end - start);
+    if (segment == "." || segment == "..")
+      return false;
+    start = end + 1;
+  }
+
+  // Drop leading slashes so the path stays relative
+  std::size_t first = out.find_first_not_of('/');
+  out.erase(0, first == std::string::npos ? out.size() : first);
+  return true;
+}
+
+bool StaticFileHandler::etag_matches(const std::string &header,
+                                     const std::string &etag) {
+  if (header.find('*') != std::string::npos)
+    return true;
+  // Weak comparison: ignore W/ prefixes on either side
+  std::string_view bare(etag);
+  if (bare.substr(0, 2) == "W/")
+    bare.remove_prefix(2);
+  return header.find(bare) != std::string::npos;
+}
+
+StaticFileHandler::StaticFileHandler(std::string urlPrefix,
+                                     std::string rootDirectory,
+                                     Options options)
+    : _prefix(std::move(urlPrefix)), _root(std::move(rootDirectory)),
+      _options(std::move(options)), _hand(_clock.end()), _inotifyFD(-1) {
+  while (!_prefix.empty() && _prefix.back() == '/')
+    _prefix.pop_back();
+  while (_root.size() > 1 && _root.back() == '/')
+    _root.pop_back();
+
+#ifndef __APPLE__
+  _inotifyFD = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_inotifyFD >= 0)
+    _stopFD = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_inotifyFD < 0 || _stopFD < 0) {
+    logging::Logger::warning(
+        std::string("StaticFileHandler: inotify unavailable, cache will not "
+                    "be invalidated: ") +
+        std::strerror(errno));
+    if (_inotifyFD >= 0)
+      ::close(_inotifyFD);
+    _inotifyFD = -1;
+  } else {
+    _watcher = std::thread([this]() { watch_loop(); });
+  }
+#endif
+  logging::Logger::debug("StaticFileHandler: serving " + _root + " at " +
+                         (_prefix.empty() ? "/" : _prefix));
+}
+
+StaticFileHandler::~StaticFileHandler(void) {
+#ifndef __APPLE__
+  if (_watcher.joinable()) {
+    std::uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(_stopFD, &one, sizeof(one));
+    _watcher.join();
+  }
+  if (_stopFD >= 0)
+    ::close(_stopFD);
+#endif
+  if (_inotifyFD >= 0)
+    ::close(_inotifyFD);
+}
+
+std::unique_ptr<http::Response>
+StaticFileHandler::handle(std::unique_ptr<http::Request> request) {
+  auto response = std::make_unique<http::Response>();
+  const std::string path = request->getURL().getPathToResource();
+
+  std::string relative;
+  if (path.compare(0, _prefix.size(), _prefix) != 0 ||
+      (path.size() > _prefix.size() && path[_prefix.size()] != '/' &&
+       !_prefix.empty()) ||
+      !decode_relative_path(path.substr(_prefix.size()), relative)) {
+    response->setStatusCode(http::StatusCode::NOT_FOUND);
+    response->setBody("Not Found");
+    return response;
+  }
+  if (relative.empty() || relative.back() == '/')
+    relative += _options.indexFile;
+
+  auto entry = lookup(relative);
+  if (!entry) {
+    response->setStatusCode(http::StatusCode::NOT_FOUND);
+    response->setBody("Not Found");
+    return response;
+  }
+
+  response->setHeader("ETag", entry->etag);
+  response->setHeader("Last-Modified", entry->lastModified);
+  response->setHeader("Accept-Ranges", "bytes");
+  if (!_options.cacheControl.empty())
+    response->setHeader("Cache-Control", _options.cacheControl);
+
+  // Conditional requests: If-None-Match takes precedence over dates
+  const auto &headers = request->getHeaders();
+  std::string ifNoneMatch = headers.get("If-None-Match", "");
+  bool notModified = false;
+  if (!ifNoneMatch.empty()) {
+    notModified = etag_matches(ifNoneMatch, entry->etag);
+  } else {
+    std::string ifModifiedSince = headers.get("If-Modified-Since", "");
+    std::time_t since = ifModifiedSince.empty()
+                            ? -1
+                            : parse_http_date(ifModifiedSince);
+    notModified = since >= 0 && entry->mtime <= since;
+  }
+  if (notModified) {
+    response->setStatusCode(http::StatusCode::NOT_MODIFIED);
+    return response;
+  }
+
+  response->setHeader("Content-Type", entry->contentType);
+  if (request->getMethod() == http::Method::HEAD) {
+    response->setHeader("Content-Length", std::to_string(entry->size));
+    return response;
+  }
+  response->setBody(http::FileRegion{entry->file, 0, entry->size});
+  return response;
+}
+
+std::shared_ptr<const StaticFileHandler::Entry>
+StaticFileHandler::lookup(const std::string &relativePath) {
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    auto it = _cache.find(relativePath);
+    if (it != _cache.end()) {
+      const auto &cached = it->second;
+#ifdef __APPLE__
+      // No inotify: revalidate the cached entry against the file system
+      struct stat info {};
+      std::string full = _root + "/" + relativePath;
+      if (::stat(full.c_str(), &info) == 0 &&
+          static_cast<std::size_t>(info.st_size) == cached.entry->size &&
+          info.st_mtime == cached.entry->mtime) {
+        cached.referenced.store(true, std::memory_order_relaxed);
+        return cached.entry;
+      }
+#else
+      // Only a flag under the shared lock, so hits never serialise
+      cached.referenced.store(true, std::memory_order_relaxed);
+      return cached.entry;
+#endif
+    }
+  }
+
+  std::string resolved = relativePath;
+  auto entry = open_entry(resolved);
+  if (!entry)
+    return nullptr;
+
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  // Directories named without a trailing slash are served uncached, since
+  // change events only name the resolved index file
+  if (_options.maxCachedFiles > 0 && resolved == relativePath) {
+    if (auto it = _cache.find(relativePath); it != _cache.end()) {
+      it->second.entry = entry; // Revalidation found the file changed
+    } else {
+      while (_cache.size() >= _options.maxCachedFiles)
+        evict_one();
+      _clock.push_back(relativePath);
+      auto &cached = _cache[relativePath];
+      cached.entry = entry;
+      cached.position = std::prev(_clock.end());
+    }
+    std::size_t slash = resolved.rfind('/');
+    watch_directory(slash == std::string::npos ? std::string()
+                                               : resolved.substr(0, slash));
+  }
+  return entry;
+}
+
+std::shared_ptr<const StaticFileHandler::Entry>
+StaticFileHandler::open_entry(std::string &relativePath) const {
+  std::string full = _root + "/" + relativePath;
+  int fd = ::open(full.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+  auto file = std::make_shared<const http::FileHandle>(fd);
+
+  struct stat info {};
+  if (::fstat(fd, &info) < 0)
+    return nullptr;
+
+  if (S_ISDIR(info.st_mode)) {
+    // A directory named without a trailing slash: serve its index file
+    relativePath += "/" + _options.indexFile;
+    full = _root + "/" + relativePath;
+    fd = ::open(full.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return nullptr;
+    file = std::make_shared<const http::FileHandle>(fd);
+    if (::fstat(fd, &info) < 0)
+      return nullptr;
+  }
+  if (!S_ISREG(info.st_mode))
+    return nullptr;
+
+  char etag[64];
+  std::snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"",
+                static_cast<unsigned long long>(info.st_ino),
+                static_cast<unsigned long long>(info.st_size),
+                static_cast<unsigned long long>(info.st_mtime));
+
+  auto entry = std::make_shared<Entry>();
+  entry->file = std::move(file);
+  entry->size = static_cast<std::size_t>(info.st_size);
+  entry->mtime = info.st_mtime;
+  entry->etag = etag;
+  entry->lastModified = format_http_date(info.st_mtime);
+  entry->contentType = content_type_for(relativePath);
+  return entry;
+}
+
+void StaticFileHandler::watch_directory(const std::string &relativeDir) {
+#ifndef __APPLE__
+  if (_inotifyFD < 0 || _watchedDirs.count(relativeDir))
+    return;
+  std::string full = relativeDir.empty() ? _root : _root + "/" + relativeDir;
+  int wd = ::inotify_add_watch(_inotifyFD, full.c_str(),
+                               IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE |
+                                   IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF);
+  if (wd < 0) {
+    logging::Logger::warning("StaticFileHandler: cannot watch " + full + ": " +
+                             std::strerror(errno));
+    return;
+  }
+  _watches[wd] = relativeDir;
+  _watchedDirs[relativeDir] = wd;
+#else
+  (void)relativeDir;
+#endif
+}
+
+void StaticFileHandler::watch_loop() {
+#ifndef __APPLE__
+  struct pollfd fds[2] = {{_inotifyFD, POLLIN, 0}, {_stopFD, POLLIN, 0}};
+  while (true) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      logging::Logger::error(
+          std::string("StaticFileHandler: poll failed, cache will not be "
+                      "invalidated: ") +
+          std::strerror(errno));
+      return;
+    }
+    if (fds[1].revents != 0)
+      return;
+    if (fds[0].revents != 0)
+      drain_events();
+  }
+#endif
+}
+
+void StaticFileHandler::drain_events() {
+#ifndef __APPLE__
+  if (_inotifyFD < 0)
+    return;
+
+  alignas(struct inotify_event) char buffer[4096];
+  ssize_t len = ::read(_inotifyFD, buffer, sizeof(buffer));
+  if (len <= 0)
+    return; // Nothing changed (EAGAIN)
+
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  do {
+    for (char *ptr = buffer; ptr < buffer + len;) {
+      auto *event = reinterpret_cast<struct inotify_event *>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF |
+                         IN_IGNORED)) {
+        // Lost track of a directory: start over
+        forget_all();
+        if (event->mask & IN_IGNORED) {
+          auto it = _watches.find(event->wd);
+          if (it != _watches.end()) {
+            _watchedDirs.erase(it->second);
+            _watches.erase(it);
+          }
+        }
+        continue;
+      }
+
+      auto it = _watches.find(event->wd);
+      if (it == _watches.end() || event->len == 0)
+        continue;
+      std::string name(event->name);
+      std::string key = it->second.empty() ? name : it->second + "/" + name;
+      forget(key);
+      logging::Logger::debug("StaticFileHandler: invalidated " + key);
+    }
+    len = ::read(_inotifyFD, buffer, sizeof(buffer));
+  } while (len > 0);
+#endif
+}
+
+void StaticFileHandler::forget(const std::string &relativePath) {
+  auto it = _cache.find(relativePath);
+  if (it == _cache.end())
+    return;
+  if (_hand == it->second.position)
+    ++_hand;
+  _clock.erase(it->second.position);
+  _cache.erase(it);
+}
+
+void StaticFileHandler::forget_all(void) {
+  _cache.clear();
+  _clock.clear();
+  _hand = _clock.end();
+}
+
+void StaticFileHandler::evict_one(void) {
+  // Every entry passed loses its flag, so this ends within two turns
+  while (!_clock.empty()) {
+    if (_hand == _clock.end())
+      _hand = _clock.begin();
+    const Cached &cached = _cache.find(*_hand)->second;
+    if (!cached.referenced.exchange(false, std::memory_order_relaxed)) {
+      std::string evicted = *_hand; // forget() frees the clock's copy
+      forget(evicted);
+      logging::Logger::debug("StaticFileHandler: evicted " + evicted);
+      return;
+    }
+    ++_hand;
+  }
+}
+
+void StaticFileHandler::clear_cache(void) {
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  forget_all();
+}
+
+std::size_t StaticFileHandler::cached_files(void) const {
+  std::shared_lock<std::shared_mutex> lock(_mutex);
+  return _cache.size();
+}
+
+std::string StaticFileHandler::content_type_for(const std::string &path) {
+  static const std::unordered_map<std::string, std::string> types = {
+      {"html", "text/html; charset=utf-8"},
+      {"htm", "text/html; charset=utf-8"},
+      {"css", "text/css; charset=utf-8"},
+      {"js", "text/javascript; charset=utf-8"},
+      {"mjs", "text/javascript; charset=utf-8"},
+      {"json", "application/json"},
+      {"map", "application/json"},
+      {"txt", "text/plain; charset=utf-8"},
+      {"csv", "text/csv; charset=utf-8"},
+      {"xml", "application/xml"},
+      {"svg", "image/svg+xml"},
+      {"png", "image/png"},
+      {"jpg", "image/jpeg"},
+      {"jpeg", "image/jpeg"},
+      {"gif", "image/gif"},
+      {"webp", "image/webp"},
+      {"avif", "image/avif"},
+      {"ico", "image/x-icon"},
+      {"woff", "font/woff"},
+      {"woff2", "font/woff2"},
+      {"ttf", "font/ttf"},
+      {"otf", "font/otf"},
+      {"wasm", "application/wasm"},
+      {"pdf", "application/pdf"},
+      {"mp4", "video/mp4"},
+      {"webm", "video/webm"},
+      {"mp3", "audio/mpeg"},
+      {"ogg", "audio/ogg"},
+      {"wav", "audio/wav"},
+      {"zip", "application/zip"},
+      {"gz", "application/gzip"},
+  };
+
+  std::size_t dot = path.rfind('.');
+  std::size_t slash = path.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return "application/octet-stream";
+  std::string ext = path.substr(dot + 1);
+  for (auto &c : ext)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  auto it = types.find(ext);
+  return it != types.end() ? it->second : "application/octet-stream";
+}
+
+std::string StaticFileHandler::format_http_date(std::time_t time) {
+  std::tm tm{};
+  ::gmtime_r(&time, &tm);
+  char buffer[64];
+  std::size_t len =
+      std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return std::string(buffer, len);
+}
+
+std::time_t StaticFileHandler::parse_http_date(const std::string &value) {
+  std::tm tm{};
+  const char *end = ::strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S", &tm);
+  if (!end)
+    return -1;
+  return ::timegm(&tm);
+}
+
+} // namespace fion
@@ -0,0 +1,136 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "http/Body.hpp"
+
+fion::http::FileHandle::FileHandle(int fd) : _fd(fd) {
+  if (fd < 0)
+    throw std::invalid_argument("Invalid file descriptor");
+}
+
+fion::http::FileHandle::~FileHandle(void) {
+  if (_fd >= 0)
+    ::close(_fd);
+}
+
+fion::http::SharedBuffer
+fion::http::SharedBuffer::fromString(std::string content) {
+  auto owner = std::make_shared<const std::string>(std::move(content));
+  std::string_view data(*owner);
+  return SharedBuffer{std::move(owner), data};
+}
+
+fion::http::FileRegion
+fion::http::FileRegion::fromPath(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open " + path + ": " +
+                             std::string(std::strerror(errno)));
+  auto file = std::make_shared<const FileHandle>(fd);
+
+  struct stat info {};
+  if (::fstat(fd, &info) < 0)
+    throw std::runtime_error("Failed to stat " + path + ": " +
+                             std::string(std::strerror(errno)));
+  if (!S_ISREG(info.st_mode))
+    throw std::runtime_error("Not a regular file: " + path);
+
+  return FileRegion{std::move(file), 0, static_cast<std::size_t>(info.st_size)};
+}
+
+fion::http::Body::Body(BodyParts parts) {
+  for (const auto &part : parts) {
+    if (!part.size())
+      throw std::invalid_argument("Body sequence parts must have a known size");
+  }
+  _content = std::move(parts);
+}
+
+std::optional<std::size_t> fion::http::Body::size(void) const {
+  switch (kind()) {
+  case BodyKind::STRING:
+    return std::get<std::string>(_content).size();
+  case BodyKind::SHARED:
+    return std::get<SharedBuffer>(_content).data.size();
+  case BodyKind::FILE:
+    return std::get<FileRegion>(_content).length;
+  case BodyKind::SEQUENCE: {
+    std::size_t total = 0;
+    for (const auto &part : std::get<BodyParts>(_content))
+      total += *part.size();
+    return total;
+  }
+  case BodyKind::GENERATOR:
+  case BodyKind::STREAM:
+  default:
+    return std::nullopt;
+  }
+}
+
+std::string_view fion::http::Body::view(void) const {
+  if (kind() == BodyKind::STRING)
+    return std::get<std::string>(_content);
+  if (kind() == BodyKind::SHARED)
+    return std::get<SharedBuffer>(_content).data;
+  return {};
+}
+
+std::string fion::http::Body::materialize(void) const {
+  switch (kind()) {
+  case BodyKind::STRING:
+  case BodyKind::SHARED:
+    return std::string(view());
+  case BodyKind::FILE: {
+    const auto &region = std::get<FileRegion>(_content);
+    std::string out(region.length, '\0');
+    std::size_t done = 0;
+    while (done < region.length) {
+      ssize_t n = ::pread(region.file->get_fd(), out.data() + done,
+                          region.length - done,
+                          region.offset + static_cast<off_t>(done));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        throw std::runtime_error("Failed to read file body");
+      done += static_cast<std::size_t>(n);
+    }
+    return out;
+  }
+  case BodyKind::GENERATOR: {
+    const auto &generator = std::get<BodyGenerator>(_content);
+    std::string out;
+    std::string chunk;
+    while (generator && generator(chunk)) {
+      out += chunk;
+      chunk.clear();
+    }
+    return out;
+  }
+  case BodyKind::STREAM: {
+    const auto &writer = std::get<std::shared_ptr<BodyWriter>>(_content);
+    std::string out;
+    while (writer) {
+      writer->pump();
+      auto chunk = writer->take();
+      if (chunk)
+        out += *chunk;
+      else if (writer->ended())
+        break;
+      else
+        throw std::runtime_error("Stream body stalled while materializing");
+    }
+    return out;
+  }
+  case BodyKind::SEQUENCE: {
+    std::string out;
+    for (const auto &part : std::get<BodyParts>(_content))
+      out += part.materialize();
+    return out;
+  }
+  }
+  return {};
+}
@@ -0,0 +1,84 @@
+#include <stdexcept>
+
+#include "http/BodyWriter.hpp"
+
+fion::http::BodyWriter::BodyWriter(Producer producer,
+                                   std::size_t highWaterMark)
+    : _producer(std::move(producer)), _highWaterMark(highWaterMark),
+      _pending(0), _ended(false), _stalled(false) {}
+
+bool fion::http::BodyWriter::write(std::string chunk) {
+  std::function<void()> resume;
+  bool writable = false;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ended)
+      throw std::logic_error("BodyWriter: write after end");
+    if (!chunk.empty()) {
+      _pending += chunk.size();
+      _chunks.push_back(std::move(chunk));
+    }
+    writable = _pending < _highWaterMark;
+    if (_stalled && !_chunks.empty()) {
+      _stalled = false;
+      resume = _resume;
+    }
+  }
+  if (resume)
+    resume();
+  return writable;
+}
+
+void fion::http::BodyWriter::end() {
+  std::function<void()> resume;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ended)
+      return;
+    _ended = true;
+    if (_stalled) {
+      _stalled = false;
+      resume = _resume;
+    }
+  }
+  if (resume)
+    resume();
+}
+
+bool fion::http::BodyWriter::ended() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _ended;
+}
+
+std::size_t fion::http::BodyWriter::pending() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _pending;
+}
+
+void fion::http::BodyWriter::pump() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ended || !_producer || _pending >= _highWaterMark)
+      return;
+  }
+  // The producer calls write(), so it must run without the lock held
+  _producer(*this);
+}
+
+std::optional<std::string> fion::http::BodyWriter::take() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_chunks.empty()) {
+    _stalled = !_ended;
+    return std::nullopt;
+  }
+  std::string chunk = std::move(_chunks.front());
+  _chunks.pop_front();
+  _pending -= chunk.size();
+  return chunk;
+}
+
+void fion::http::BodyWriter::set_resume_callback(
+    std::function<void()> resume) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _resume = std::move(resume);
+}
@@ -6,9 +6,34 @@ fion::http::Headers::Headers(void) {}
 
 fion::http::Headers::~Headers(void) {}
 
+fion::http::Headers::Headers(const Headers &other) : _headers(other._headers) {}
+
+fion::http::Headers &fion::http::Headers::operator=(const Headers &other) {
+  _headers = other._headers;
+  return *this;
+}
+
+void fion::http::Headers::assign(std::string_view key,
+                                 std::string_view value) {
+  auto it = _headers.find(key);
+  if (it != _headers.end()) {
+    it->second.assign(value);
+    return;
+  }
+  if (_spare.empty()) {
+    _headers.emplace(key, value);
+    return;
+  }
+  Map::node_type node = std::move(_spare.back());
+  _spare.pop_back();
+  node.key().assign(key);
+  node.mapped().assign(value);
+  _headers.insert(std::move(node));
+}
+
 void fion::http::Headers::set(const std::string &key,
                               const std::string &value) {
-  _headers[key] = value;
+  assign(key, value);
 }
 
 std::string fion::http::Headers::get(const std::string &key) const {
@@ -41,6 +66,12 @@ bool fion::http::Headers::remove(const std::string &key) {
 
 void fion::http::Headers::clear(void) { _headers.clear(); }
 
+void fion::http::Headers::recycle(void) {
+  while (!_headers.empty() && _spare.size() < MAX_SPARE_ENTRIES)
+    _spare.push_back(_headers.extract(_headers.begin()));
+  _headers.clear();
+}
+
 std::vector<std::string> fion::http::Headers::getKeys(void) const {
   std::vector<std::string> keys;
   keys.reserve(_headers.size());
@@ -54,25 +85,28 @@ size_t fion::http::Headers::size(void) const { return _headers.size(); }
 
 bool fion::http::Headers::empty(void) const { return _headers.empty(); }
 
-const std::map<std::string, std::string> &
-fion::http::Headers::getAll(void) const {
+const fion::http::Headers::Map &fion::http::Headers::getAll(void) const {
   return _headers;
 }
 
 void fion::http::Headers::parseFromRaw(const std::string &rawHeaders) {
-  std::istringstream stream(rawHeaders);
-  std::string line;
-  while (std::getline(stream, line) && line != "\r") {
+  std::string_view rest(rawHeaders);
+  while (!rest.empty()) {
+    std::size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view()
+                                         : rest.substr(end + 1);
+    if (line == "\r")
+      break;
     auto delimiterPos = line.find(": ");
-    if (delimiterPos != std::string::npos) {
-      std::string key = line.substr(0, delimiterPos);
-      std::string value = line.substr(delimiterPos + 2);
+    if (delimiterPos != std::string_view::npos) {
+      std::string_view value = line.substr(delimiterPos + 2);
 
       // Remove trailing \r if present
       if (!value.empty() && value.back() == '\r')
-        value.pop_back();
+        value.remove_suffix(1);
 
-      _headers[key] = value;
+      assign(line.substr(0, delimiterPos), value);
     }
   }
 }
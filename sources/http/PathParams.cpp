@@ -0,0 +1,55 @@
+#include <stdexcept>
+
+#include "http/PathParams.hpp"
+
+void fion::http::PathParams::assign(std::string_view path, Names names,
+                                    const std::string_view *values,
+                                    std::size_t count) {
+  if (count > MAX_PATH_PARAMS)
+    throw std::length_error("Too many path parameters");
+  _names = names;
+  _storage.clear();
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string_view value = values[i];
+    if (value.data() >= path.data() &&
+        value.data() + value.size() <= path.data() + path.size()) {
+      _spans[i] = {static_cast<std::uint32_t>(value.data() - path.data()),
+                   static_cast<std::uint32_t>(value.size())};
+    } else {
+      _spans[i] = {static_cast<std::uint32_t>(_storage.size()) | STORED,
+                   static_cast<std::uint32_t>(value.size())};
+      _storage.append(value);
+    }
+  }
+  _count = count;
+}
+
+void fion::http::PathParams::clear(void) {
+  _names = nullptr;
+  _storage.clear();
+  _count = 0;
+}
+
+std::string_view fion::http::PathParams::name(std::size_t index) const {
+  if (!_names || index >= _names->size())
+    return {};
+  return (*_names)[index];
+}
+
+std::string_view fion::http::PathParams::value(std::string_view path,
+                                               std::size_t index) const {
+  auto [offset, length] = _spans[index];
+  if (offset & STORED)
+    return std::string_view(_storage).substr(offset & ~STORED, length);
+  return path.substr(offset, length);
+}
+
+std::optional<std::string_view>
+fion::http::PathParams::find(std::string_view path,
+                             std::string_view name) const {
+  for (std::size_t i = 0; i < _count; ++i) {
+    if (this->name(i) == name)
+      return value(path, i);
+  }
+  return std::nullopt;
+}
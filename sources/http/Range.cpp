@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <random>
+
+#include "http/Range.hpp"
+
+namespace {
+std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+    value.remove_prefix(1);
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+    value.remove_suffix(1);
+  return value;
+}
+
+bool parse_position(std::string_view text, std::size_t &out) {
+  if (text.empty())
+    return false;
+  std::uint64_t value = 0;
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size())
+    return false;
+  out = static_cast<std::size_t>(value);
+  return true;
+}
+
+std::string make_boundary(void) {
+  thread_local std::mt19937_64 engine{std::random_device{}()};
+  static const char digits[] = "0123456789abcdef";
+  std::string boundary = "fion-";
+  std::uint64_t value = engine();
+  for (int i = 0; i < 16; ++i, value >>= 4)
+    boundary += digits[value & 0xF];
+  return boundary;
+}
+
+// A slice of an in-memory or file body; never copies the bytes
+fion::http::Body slice(const fion::http::Body &body,
+                       const fion::http::ByteRange &range) {
+  if (body.kind() == fion::http::BodyKind::FILE) {
+    fion::http::FileRegion region = body.asFile();
+    region.offset += static_cast<off_t>(range.first);
+    region.length = range.length();
+    return region;
+  }
+  const auto &shared = body.asShared();
+  return fion::http::SharedBuffer{shared.owner,
+                                  shared.data.substr(range.first,
+                                                     range.length())};
+}
+
+std::string content_range(const fion::http::ByteRange &range,
+                          std::size_t size) {
+  return "bytes " + std::to_string(range.first) + "-" +
+         std::to_string(range.last) + "/" + std::to_string(size);
+}
+} // namespace
+
+std::optional<std::vector<fion::http::ByteRange>>
+fion::http::parseRange(std::string_view header, std::size_t size) {
+  header = trim(header);
+  if (header.substr(0, 6) != "bytes=")
+    return std::nullopt;
+  header.remove_prefix(6);
+
+  std::vector<ByteRange> ranges;
+  std::size_t specs = 0;
+  while (true) {
+    std::size_t comma = header.find(',');
+    std::string_view spec = trim(header.substr(0, comma));
+    if (!spec.empty()) {
+      if (++specs > MAX_BYTE_RANGES)
+        return std::nullopt;
+      std::size_t dash = spec.find('-');
+      if (dash == std::string_view::npos)
+        return std::nullopt;
+      std::string_view firstText = spec.substr(0, dash);
+      std::string_view lastText = spec.substr(dash + 1);
+      std::size_t first = 0;
+      std::size_t last = 0;
+
+      if (firstText.empty()) {
+        // Suffix range: the last N bytes
+        if (!parse_position(lastText, last))
+          return std::nullopt;
+        if (last > 0 && size > 0)
+          ranges.push_back({size - std::min(last, size), size - 1});
+      } else {
+        if (!parse_position(firstText, first))
+          return std::nullopt;
+        if (lastText.empty())
+          last = SIZE_MAX;
+        else if (!parse_position(lastText, last) || last < first)
+          return std::nullopt;
+        if (first < size)
+          ranges.push_back({first, std::min(last, size - 1)});
+      }
+    }
+    if (comma == std::string_view::npos)
+      break;
+    header.remove_prefix(comma + 1);
+  }
+  if (specs == 0)
+    return std::nullopt;
+
+  // Coalesce overlapping and adjacent ranges
+  std::sort(ranges.begin(), ranges.end(),
+            [](const ByteRange &a, const ByteRange &b) {
+              return a.first < b.first;
+            });
+  std::vector<ByteRange> merged;
+  for (const auto &range : ranges) {
+    if (!merged.empty() && range.first <= merged.back().last + 1)
+      merged.back().last = std::max(merged.back().last, range.last);
+    else
+      merged.push_back(range);
+  }
+  return merged;
+}
+
+bool fion::http::applyRange(Response &response, std::string_view range,
+                            std::string_view ifRange) {
+  if (range.empty() || response.getStatusCode() != StatusCode::OK)
+    return false;
+  const Body &current = response.getBody();
+  BodyKind kind = current.kind();
+  if (kind != BodyKind::STRING && kind != BodyKind::SHARED &&
+      kind != BodyKind::FILE)
+    return false;
+  const std::size_t size = *current.size();
+
+  Headers &headers = response.getHeaders();
+  ifRange = trim(ifRange);
+  if (!ifRange.empty()) {
+    // Strong comparison for entity tags, exact match for dates
+    if (ifRange.front() == '"') {
+      auto etag = headers.getOptional("ETag");
+      if (!etag || *etag != ifRange)
+        return false;
+    } else {
+      auto lastModified = headers.getOptional("Last-Modified");
+      if (!lastModified || *lastModified != ifRange)
+        return false;
+    }
+  }
+
+  auto ranges = parseRange(range, size);
+  if (!ranges)
+    return false;
+
+  headers.remove("Content-Length");
+  if (ranges->empty()) {
+    response.setStatusCode(StatusCode::RANGE_NOT_SATISFIABLE);
+    response.setHeader("Content-Range", "bytes */" + std::to_string(size));
+    response.setBody(Body());
+    return true;
+  }
+
+  // Slices share the original bytes, so strings become shared buffers once
+  Body full = response.releaseBody();
+  if (full.kind() == BodyKind::STRING)
+    full = SharedBuffer::fromString(full.asString());
+
+  response.setStatusCode(StatusCode::PARTIAL_CONTENT);
+  if (ranges->size() == 1) {
+    response.setHeader("Content-Range", content_range(ranges->front(), size));
+    response.setBody(slice(full, ranges->front()));
+    return true;
+  }
+
+  const std::string boundary = make_boundary();
+  const std::string contentType =
+      headers.get("Content-Type", "application/octet-stream");
+  BodyParts parts;
+  parts.reserve(ranges->size() * 2 + 1);
+  for (std::size_t i = 0; i < ranges->size(); ++i) {
+    parts.emplace_back((i == 0 ? "--" : "\r\n--") + boundary +
+                       "\r\nContent-Type: " + contentType +
+                       "\r\nContent-Range: " +
+                       content_range((*ranges)[i], size) + "\r\n\r\n");
+    parts.push_back(slice(full, (*ranges)[i]));
+  }
+  parts.emplace_back("\r\n--" + boundary + "--\r\n");
+  response.setHeader("Content-Type",
+                     "multipart/byteranges; boundary=" + boundary);
+  response.setBody(Body(std::move(parts)));
+  return true;
+}
@@ -26,6 +26,30 @@ const fion::http::Method fion::http::stringToMethod(std::string rawMethod) {
     throw std::invalid_argument("Invalid HTTP Method");
 }
 
+const std::string fion::http::methodToString(const Method method) {
+  switch (method) {
+  case fion::http::Method::GET:
+    return "GET";
+  case fion::http::Method::HEAD:
+    return "HEAD";
+  case fion::http::Method::POST:
+    return "POST";
+  case fion::http::Method::PUT:
+    return "PUT";
+  case fion::http::Method::DELETE:
+    return "DELETE";
+  case fion::http::Method::CONNECT:
+    return "CONNECT";
+  case fion::http::Method::OPTIONS:
+    return "OPTIONS";
+  case fion::http::Method::TRACE:
+    return "TRACE";
+  case fion::http::Method::PATCH:
+    return "PATCH";
+  }
+  return "";
+}
+
 void fion::http::Request::parseStartLine(const std::string &rawStartLine) {
   std::istringstream stream(rawStartLine);
   std::string rawMethod;
@@ -58,12 +82,23 @@ void fion::http::Request::parseHeaders(const std::string &rawHeaders) {
 }
 
 void fion::http::Request::parseBody(const std::string &rawBody) {
-  _body = rawBody;
+  _body.assign(rawBody); // Keeps the capacity of a recycled request
 }
 
+fion::http::Request::Request(void)
+    : _method(Method::GET), _version(Version::HTTP_1_1) {}
+
 fion::http::Request::Request(std::string rawStartLine,
                              const std::string &rawHeaders,
                              const std::string &rawBody) {
+  parse(rawStartLine, rawHeaders, rawBody);
+}
+
+void fion::http::Request::parse(const std::string &rawStartLine,
+                                const std::string &rawHeaders,
+                                const std::string &rawBody) {
+  _headers.recycle();
+  _params.clear();
   try {
     parseStartLine(rawStartLine);
   } catch (const std::invalid_argument &) {
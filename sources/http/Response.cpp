@@ -141,22 +141,23 @@ fion::http::Response::Response(void)
 
 fion::http::Response::~Response(void) {}
 
-const std::string fion::http::Response::toRawResponse(void) const {
-  std::ostringstream rawResponse;
+std::string fion::http::Response::toRawHead(void) const {
+  std::ostringstream rawHead;
 
   // Start line
-  rawResponse << fion::http::VersionToString(_version) << " "
-              << static_cast<unsigned short>(_statusCode) << " "
-              << fion::http::statusCodeToString(_statusCode) << "\r\n";
+  rawHead << fion::http::VersionToString(_version) << " "
+          << static_cast<unsigned short>(_statusCode) << " "
+          << fion::http::statusCodeToString(_statusCode) << "\r\n";
 
   // Headers
-  rawResponse << _headers.toRawString();
+  rawHead << _headers.toRawString();
 
   // Blank line to separate headers from body
-  rawResponse << "\r\n";
+  rawHead << "\r\n";
 
-  // Body
-  rawResponse << _body;
+  return rawHead.str();
+}
 
-  return rawResponse.str();
+const std::string fion::http::Response::toRawResponse(void) const {
+  return toRawHead() + _body.materialize();
 }
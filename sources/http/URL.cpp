@@ -186,7 +186,9 @@ std::string URL::getDomainName(void) const { return domainName; }
 
 std::uint16_t URL::getPort(void) const { return port; }
 
-std::string URL::getPathToResource(void) const { return pathToResource; }
+const std::string &URL::getPathToResource(void) const {
+  return pathToResource;
+}
 
 std::map<std::string, std::string> URL::getQueryParameters(void) const {
   return queryParameters;
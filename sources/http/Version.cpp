@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include "http/Version.hpp"
 
 const fion::http::Version
@@ -0,0 +1,99 @@
+#include "network/AdmissionControl.hpp"
+#include "logging/Logger.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fion::network {
+namespace {
+#ifdef __APPLE__
+constexpr int kSendFlags = MSG_DONTWAIT;
+#else
+constexpr int kSendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#endif
+} // namespace
+
+AdmissionControl::AdmissionControl(const ServerOptions &options)
+    : _maxConnections(options.maxConnections),
+      _maxQueuedTasks(options.maxQueuedTasks),
+      _action(options.overloadAction) {
+  if (options.queueDelayTarget.count() > 0)
+    _taskDelay = std::make_unique<QueueDelayController>(
+        options.queueDelayTarget, options.queueDelayInterval);
+  static constexpr char body[] = "Service Unavailable";
+  _rejection = http::SharedBuffer::fromString(
+      "HTTP/1.1 503 Service Unavailable\r\n"
+      "Retry-After: " +
+      std::to_string(options.retryAfter.count()) +
+      "\r\n"
+      "Content-Type: text/plain\r\n"
+      "Content-Length: " +
+      std::to_string(sizeof(body) - 1) +
+      "\r\n"
+      "Connection: close\r\n"
+      "\r\n" +
+      body);
+}
+
+bool AdmissionControl::admit_connection(void) {
+  std::size_t count = _connections.fetch_add(1, std::memory_order_relaxed);
+  if (_maxConnections > 0 && count >= _maxConnections) {
+    _connections.fetch_sub(1, std::memory_order_relaxed);
+    _rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void AdmissionControl::reject_connection(int fd) {
+  if (_action == OverloadAction::REJECT) {
+#ifdef __APPLE__
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    // A fresh socket buffer takes the whole response; if not, the client
+    // just sees the close
+    ::send(fd, _rejection.data.data(), _rejection.data.size(), kSendFlags);
+  }
+  ::close(fd);
+  logging::Logger::debug("AdmissionControl: rejected connection fd=" +
+                         std::to_string(fd));
+}
+
+bool AdmissionControl::admit_task(void) {
+  std::size_t count = _queuedTasks.fetch_add(1, std::memory_order_relaxed);
+  if (_maxQueuedTasks > 0 && count >= _maxQueuedTasks) {
+    _queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    _rejectedTasks.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+AdmissionStats AdmissionControl::stats(
+    std::vector<QueueDelayController::Stats> poolQueues) const {
+  AdmissionStats stats;
+  stats.connections = _connections.load(std::memory_order_relaxed);
+  stats.queuedTasks = _queuedTasks.load(std::memory_order_relaxed);
+  stats.rejectedConnections =
+      _rejectedConnections.load(std::memory_order_relaxed);
+  stats.rejectedRequests = _rejectedRequests.load(std::memory_order_relaxed);
+  stats.rejectedTasks = _rejectedTasks.load(std::memory_order_relaxed);
+  if (_taskDelay)
+    stats.workerQueue = _taskDelay->stats();
+  stats.poolQueues = std::move(poolQueues);
+
+  auto add = [&stats](const QueueDelayController::Stats &queue) {
+    stats.shedRequests += queue.shed;
+    stats.overloaded = stats.overloaded || queue.overloaded;
+    stats.queueDelay = std::max(stats.queueDelay, queue.lastDelay);
+  };
+  add(stats.workerQueue);
+  for (const auto &queue : stats.poolQueues)
+    add(queue);
+  return stats;
+}
+} // namespace fion::network
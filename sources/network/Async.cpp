@@ -0,0 +1,68 @@
+#include "network/Async.hpp"
+
+#include <stdexcept>
+
+namespace fion::network {
+EventLoop &current_loop(void) {
+  EventLoop *loop = EventLoop::current();
+  if (!loop)
+    throw std::logic_error(
+        "awaited outside an event loop thread (use sync_wait)");
+  return *loop;
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  current_loop().add_timer(_delay, [handle]() { handle.resume(); });
+}
+
+void ReadyAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  current_loop().watch_fd(_fd, _events, [this, handle](uint32_t events) {
+    _fired = events;
+    handle.resume();
+  });
+}
+
+ChunkReader::ChunkReader(http::BodyWriter &source)
+    : _state(std::make_shared<State>()) {
+  _state->source = &source;
+  // Runs on the producer's thread; the check itself is done on the loop.
+  // The state is held weakly so a writer outliving the reader is harmless.
+  std::weak_ptr<State> weak = _state;
+  source.set_resume_callback([weak]() {
+    auto state = weak.lock();
+    EventLoop *loop = state ? state->loop.load() : nullptr;
+    if (!loop)
+      return;
+    loop->post([weak]() {
+      auto state = weak.lock();
+      if (!state || !state->waiting || !try_take(*state))
+        return;
+      std::exchange(state->waiting, nullptr).resume();
+    });
+  });
+}
+
+ChunkReader::~ChunkReader(void) { _state->source->set_resume_callback({}); }
+
+bool ChunkReader::try_take(State &state) {
+  // An empty take() marks the writer as stalled, so its next write() or
+  // end() calls the resume callback again
+  state.chunk = state.source->take();
+  return state.chunk || state.source->ended();
+}
+
+bool ChunkReader::Awaiter::await_ready(void) {
+  // The callback posts to this loop, so set it before the first take()
+  _state->loop = &current_loop();
+  return try_take(*_state);
+}
+
+void ChunkReader::Awaiter::await_suspend(std::coroutine_handle<> handle) {
+  _state->waiting = handle;
+}
+
+std::optional<std::string> ChunkReader::Awaiter::await_resume(void) {
+  return std::move(_state->chunk);
+}
+
+} // namespace fion::network
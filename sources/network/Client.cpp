@@ -1,12 +1,42 @@
 #include "network/Client.hpp"
 #include "logging/Logger.hpp"
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <iterator>
 #include <stdexcept>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifndef __APPLE__
+#include <sys/sendfile.h>
+#endif
+
 namespace fion::network {
-Client::Client(int fd) : _fd(fd), _state(ClientState::READING_REQUEST) {
+namespace {
+#ifdef __APPLE__
+constexpr int kSendFlags = 0;
+#else
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#endif
+
+// Upper bound on the parts gathered into one sendmsg(2)
+constexpr std::size_t kMaxIovecs = 16;
+
+// Static framing pieces for chunked transfer coding; no owner needed
+const http::SharedBuffer kChunkEnd{nullptr, "\r\n"};
+const http::SharedBuffer kLastChunk{nullptr, "0\r\n\r\n"};
+
+bool is_contiguous(const http::Body &body) {
+  return body.kind() == http::BodyKind::STRING ||
+         body.kind() == http::BodyKind::SHARED;
+}
+} // namespace
+
+Client::Client(int fd)
+    : _fd(fd), _outgoingOffset(0), _chunked(false), _waitingForStream(false),
+      _state(ClientState::READING_REQUEST) {
   if (fd < 0)
     throw std::invalid_argument("Invalid file descriptor");
   logging::Logger::debug("Client: created for fd=" + std::to_string(fd));
@@ -20,8 +50,12 @@ Client::~Client() {
   }
 }
 
-Client::Client(Client &&other) noexcept : _fd(other._fd), _state(other._state) {
+Client::Client(Client &&other) noexcept
+    : _fd(other._fd), _outgoing(std::move(other._outgoing)),
+      _outgoingOffset(other._outgoingOffset), _chunked(other._chunked),
+      _waitingForStream(other._waitingForStream), _state(other._state) {
   other._fd = -1;
+  other._outgoingOffset = 0;
   // Note: buffers cannot be moved due to mutex, they will be empty in the new
   // object
 }
@@ -32,9 +66,14 @@ Client &Client::operator=(Client &&other) noexcept {
       ::close(_fd);
 
     _fd = other._fd;
+    _outgoing = std::move(other._outgoing);
+    _outgoingOffset = other._outgoingOffset;
+    _chunked = other._chunked;
+    _waitingForStream = other._waitingForStream;
     _state = other._state;
 
     other._fd = -1;
+    other._outgoingOffset = 0;
     // Note: buffers cannot be moved due to mutex
   }
   return *this;
@@ -57,33 +96,215 @@ ssize_t Client::readRequest() {
 }
 
 ssize_t Client::writeResponse() {
-  auto data = _responseBuffer.getData();
-  if (data.empty())
-    return 0;
+  ssize_t total = 0;
+  _waitingForStream = false;
 
-  ssize_t bytes_sent = ::send(_fd, data.data(), data.size(), 0);
+  while (!_outgoing.empty()) {
+    const http::Body &front = _outgoing.front();
+    if (front.empty()) {
+      _outgoing.pop_front();
+      _outgoingOffset = 0;
+      continue;
+    }
 
-  if (bytes_sent > 0) {
-    // For simplicity, we assume all data is sent at once
-    // In a production system, you'd need to handle partial sends
-    _responseBuffer.clear();
-    logging::Logger::debug("Client fd=" + std::to_string(_fd) +
-                           " sent=" + std::to_string(bytes_sent));
-  } else {
-    logging::Logger::error("Client fd=" + std::to_string(_fd) +
-                           " send error=" + std::to_string(bytes_sent));
+    ssize_t sent = 0;
+
+    switch (front.kind()) {
+    case http::BodyKind::STRING:
+    case http::BodyKind::SHARED:
+      sent = send_contiguous();
+      break;
+    case http::BodyKind::FILE:
+      sent = send_file_region(front.asFile());
+      break;
+    case http::BodyKind::GENERATOR: {
+      // Pull the next chunk and queue it ahead of the generator
+      std::string chunk;
+      const auto &generator = front.asGenerator();
+      if (generator && generator(chunk))
+        queue_chunk(std::move(chunk));
+      else
+        finish_streamed_part();
+      continue;
+    }
+    case http::BodyKind::STREAM: {
+      http::BodyWriter *writer = front.asStream().get();
+      if (!writer) {
+        finish_streamed_part();
+        continue;
+      }
+      writer->pump();
+      if (auto chunk = writer->take()) {
+        queue_chunk(std::move(*chunk));
+        continue;
+      }
+      if (writer->ended()) {
+        finish_streamed_part();
+        continue;
+      }
+      // The producer has nothing yet; its resume callback restarts writing
+      logging::Logger::debug("Client fd=" + std::to_string(_fd) +
+                             " stream waiting for producer");
+      _waitingForStream = true;
+      return total;
+    }
+    case http::BodyKind::SEQUENCE: {
+      // Splice the parts in so each one keeps its own send path
+      http::BodyParts parts = front.asSequence();
+      _outgoing.pop_front();
+      _outgoingOffset = 0;
+      _outgoing.insert(_outgoing.begin(), std::make_move_iterator(parts.begin()),
+                       std::make_move_iterator(parts.end()));
+      continue;
+    }
+    }
+
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break; // Socket is full, wait for the next write event
+      logging::Logger::error("Client fd=" + std::to_string(_fd) +
+                             " send error: " + std::strerror(errno));
+      return -1;
+    }
+    if (sent == 0) {
+      // A file shorter than the advertised region would loop forever
+      logging::Logger::error("Client fd=" + std::to_string(_fd) +
+                             " send made no progress");
+      return -1;
+    }
+
+    consume_outgoing(static_cast<std::size_t>(sent));
+    total += sent;
+  }
+
+  logging::Logger::debug("Client fd=" + std::to_string(_fd) +
+                         " sent=" + std::to_string(total) + " pending=" +
+                         std::to_string(_outgoing.size()));
+  return total;
+}
+
+ssize_t Client::send_contiguous() {
+  iovec iov[kMaxIovecs];
+  std::size_t count = 0;
+  std::size_t offset = _outgoingOffset;
+
+  for (const auto &part : _outgoing) {
+    if (count == kMaxIovecs || !is_contiguous(part))
+      break;
+    std::string_view data = part.view().substr(offset);
+    offset = 0;
+    if (data.empty())
+      continue;
+    iov[count].iov_base = const_cast<char *>(data.data());
+    iov[count].iov_len = data.size();
+    ++count;
   }
 
-  return bytes_sent;
+  msghdr message{};
+  message.msg_iov = iov;
+  message.msg_iovlen = count;
+  return ::sendmsg(_fd, &message, kSendFlags);
+}
+
+ssize_t Client::send_file_region(const http::FileRegion &region) {
+  std::size_t remaining = region.length - _outgoingOffset;
+  off_t offset = region.offset + static_cast<off_t>(_outgoingOffset);
+#ifdef __APPLE__
+  off_t len = static_cast<off_t>(remaining);
+  int result = ::sendfile(region.file->get_fd(), _fd, offset, &len, nullptr, 0);
+  if (result < 0 && !(errno == EAGAIN && len > 0))
+    return -1;
+  return static_cast<ssize_t>(len);
+#else
+  return ::sendfile(_fd, region.file->get_fd(), &offset, remaining);
+#endif
+}
+
+void Client::queue_chunk(std::string chunk) {
+  if (chunk.empty())
+    return; // An empty chunk would read as the end of a chunked body
+
+  if (!_chunked) {
+    _outgoing.emplace_front(std::move(chunk));
+    return;
+  }
+
+  char size_line[24];
+  int len = std::snprintf(size_line, sizeof(size_line), "%zx\r\n",
+                          chunk.size());
+  _outgoing.emplace_front(kChunkEnd);
+  _outgoing.emplace_front(std::move(chunk));
+  _outgoing.emplace_front(std::string(size_line, static_cast<size_t>(len)));
+}
+
+void Client::finish_streamed_part() {
+  _outgoing.pop_front();
+  _outgoingOffset = 0;
+  if (_chunked)
+    _outgoing.emplace_front(kLastChunk);
+}
+
+void Client::consume_outgoing(std::size_t len) {
+  while (!_outgoing.empty()) {
+    std::size_t size = _outgoing.front().size().value_or(0);
+    std::size_t remaining = size - _outgoingOffset;
+    if (len < remaining) {
+      _outgoingOffset += len;
+      return;
+    }
+    len -= remaining;
+    _outgoing.pop_front();
+    _outgoingOffset = 0;
+    if (len == 0)
+      return;
+  }
 }
 
 void Client::prepare_response(const http::Response &response) {
-  std::string raw_response = response.toRawResponse();
-  _responseBuffer.clear();
-  _responseBuffer.append(raw_response.data(), raw_response.size());
+  http::Response copy = response;
+  prepare_response(std::move(copy));
+}
+
+void Client::prepare_response(http::Response &&response) {
+  take_response(response);
+}
+
+void Client::take_response(http::Response &response, bool framed) {
+  http::Body body = response.releaseBody();
+  auto size = body.size();
+  const auto &headers = response.getHeaders();
+  framed = framed || headers.has("Content-Length") ||
+           headers.has("Transfer-Encoding");
+  auto status = static_cast<int>(response.getStatusCode());
+  if (status < 200 || status == 204 || status == 304)
+    framed = true; // These responses never carry a body
+  _chunked = false;
+  if (size && !framed) {
+    response.setHeader("Content-Length", std::to_string(*size));
+  } else if (!size && !framed &&
+             response.getVersion() == http::Version::HTTP_1_1) {
+    response.setHeader("Transfer-Encoding", "chunked");
+    _chunked = true;
+  }
+
+  std::string head = response.toRawHead();
+  clear_response_buffer();
+  _outgoing.emplace_back(std::move(head));
+  if (!body.empty())
+    _outgoing.push_back(std::move(body));
+
   logging::Logger::debug(
-      "Client fd=" + std::to_string(_fd) +
-      " response prepared, size=" + std::to_string(raw_response.size()));
+      "Client fd=" + std::to_string(_fd) + " response prepared, head=" +
+      std::to_string(_outgoing.front().view().size()) + " body=" +
+      (size ? std::to_string(*size) : std::string("streamed")));
+}
+
+void Client::prepare_raw(http::SharedBuffer response) {
+  clear_response_buffer();
+  _chunked = false;
+  _outgoing.emplace_back(std::move(response));
 }
 
 bool Client::is_request_ready() const {
@@ -5,7 +5,7 @@
 namespace fion::network {
 void ConnectionPool::addClient(int fd) {
   std::lock_guard<std::mutex> lock(_mutex);
-  _clients[fd] = std::make_unique<Client>(fd);
+  _clients[fd] = std::make_shared<Client>(fd);
   logging::Logger::debug("ConnectionPool: added client fd=" +
                          std::to_string(fd));
 }
@@ -25,4 +25,21 @@ Client *ConnectionPool::getClient(int fd) {
   return nullptr;
 }
 
+std::shared_ptr<Client> ConnectionPool::getSharedClient(int fd) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _clients.find(fd);
+  if (it != _clients.end())
+    return it->second;
+  return nullptr;
+}
+
+std::vector<int> ConnectionPool::getClientFds() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<int> fds;
+  fds.reserve(_clients.size());
+  for (const auto &entry : _clients)
+    fds.push_back(entry.first);
+  return fds;
+}
+
 } // namespace fion::network
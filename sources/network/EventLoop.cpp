@@ -1,38 +1,271 @@
 #include "network/EventLoop.hpp"
 #include "logging/Logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#ifdef __APPLE__
+#include <fcntl.h>
+#else
+#include <sys/eventfd.h>
+#endif
 
 namespace fion::network {
-EventLoop::EventLoop() : _running(false) {}
+namespace {
+thread_local EventLoop *currentLoop = nullptr;
+
+// Busy polling backs off to one spin per this many wakeups plus one
+constexpr unsigned MAX_SPIN_SKIP = 63;
+
+// Orders the timer heap so the earliest deadline is at the front
+struct LaterDeadline {
+  template <typename Timer>
+  bool operator()(const Timer &a, const Timer &b) const {
+    if (a.deadline != b.deadline)
+      return a.deadline > b.deadline;
+    return a.sequence > b.sequence;
+  }
+};
+} // namespace
 
-EventLoop::~EventLoop() { stop(); }
+EventLoop::EventLoop() : _running(false) {
+#ifdef __APPLE__
+  int fds[2];
+  if (::pipe(fds) < 0)
+    throw std::runtime_error("Failed to create wakeup pipe: " +
+                             std::string(std::strerror(errno)));
+  for (int fd : fds) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  _wakeupFd = fds[0];
+  _wakeupWriteFd = fds[1];
+#else
+  _wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_wakeupFd < 0)
+    throw std::runtime_error("Failed to create wakeup eventfd: " +
+                             std::string(std::strerror(errno)));
+  _wakeupWriteFd = _wakeupFd;
+#endif
+  // Level-triggered: stays readable until run_posted() drains it
+  _poller.addFD(_wakeupFd, static_cast<uint32_t>(PollerEvent::READ));
+}
+
+EventLoop::~EventLoop() {
+  stop();
+  // A task may have run, and its owner let us be destroyed, before the
+  // post() that queued it woke us up
+  while (_posting.load(std::memory_order_acquire) != 0)
+    std::this_thread::yield();
+  // Posted after the last run(): destroyed without running
+  PostedTask *node = _posted.exchange(nullptr, std::memory_order_acquire);
+  while (node)
+    delete std::exchange(node, node->next);
+  ::close(_wakeupFd);
+  if (_wakeupWriteFd != _wakeupFd)
+    ::close(_wakeupWriteFd);
+}
 
 void EventLoop::run() {
   if (_running.exchange(true))
     return; // Already running
 
+  // Loops may nest (a loop run from a callback of another one)
+  EventLoop *outer = std::exchange(currentLoop, this);
+
   logging::Logger::debug("EventLoop: started");
   while (_running.load()) {
     try {
-      // Poll for events with a timeout to allow checking _running flag
-      auto events = _poller.poll(100); // 100ms timeout
+      // Blocks until an event, a posted task or stop(), or the next timer
+      auto polling = std::chrono::steady_clock::now();
+      auto events = spin();
+      if (events.empty()) {
+        auto blocking = std::chrono::steady_clock::now();
+        _waitingSince.store(blocking.time_since_epoch().count(),
+                            std::memory_order_relaxed);
+        events = _poller.poll(poll_timeout());
+        auto woken = std::chrono::steady_clock::now();
+        _waitingSince.store(0, std::memory_order_relaxed);
+        _idleTicks.fetch_add((woken - blocking).count(),
+                             std::memory_order_relaxed);
+        // An event a spin would have caught: the load is back. Only when
+        // this wakeup skipped spinning (spin() counted it), since after a
+        // spin the budget already ran out before the event came.
+        if (_busyPoll.count() > 0 && _spinSkipped > 0 && !events.empty() &&
+            woken - blocking < _busyPoll)
+          _spinSkip = 0;
+      }
+      auto previous = std::exchange(_polledAt, std::chrono::steady_clock::now());
+      // Events found without waiting were pending while the last batch ran
+      bool waited = _polledAt - polling > std::chrono::microseconds(50);
+      _readySince = waited || previous.time_since_epoch().count() == 0
+                        ? _polledAt
+                        : previous;
       if (!events.empty()) {
         logging::Logger::debug("EventLoop: polled events=" +
                                std::to_string(events.size()));
       }
       for (const auto &event : events) {
-        if (_event_callback) {
+        if (event.fd == _wakeupFd) {
+          run_posted();
+        } else if (auto watcher = _watchers.find(event.fd);
+                   watcher != _watchers.end()) {
+          auto callback = std::move(watcher->second);
+          _watchers.erase(watcher);
+          _poller.removeFD(event.fd);
+          callback(event.events);
+        } else if (_event_callback) {
           _event_callback(event.fd, event.events);
         }
       }
+      run_timers();
     } catch (const std::exception &e) {
       // Log error but continue running
       logging::Logger::error(std::string("EventLoop: exception: ") + e.what());
     }
   }
+  // Tasks posted before stop() still run on this thread
+  run_posted();
+  currentLoop = outer;
   logging::Logger::debug("EventLoop: stopped");
 }
 
-void EventLoop::stop() { _running.store(false); }
+EventLoop *EventLoop::current() { return currentLoop; }
+
+void EventLoop::add_timer(std::chrono::milliseconds delay, Task callback) {
+  _timers.push_back(Timer{std::chrono::steady_clock::now() + delay,
+                          _timerSequence++, std::move(callback)});
+  std::push_heap(_timers.begin(), _timers.end(), LaterDeadline{});
+}
+
+void EventLoop::watch_fd(int fd, uint32_t events,
+                         std::function<void(uint32_t)> callback) {
+  _poller.addFD(fd, events);
+  _watchers[fd] = std::move(callback);
+}
+
+void EventLoop::run_timers() {
+  auto now = std::chrono::steady_clock::now();
+  while (!_timers.empty() && _timers.front().deadline <= now) {
+    std::pop_heap(_timers.begin(), _timers.end(), LaterDeadline{});
+    Task callback = std::move(_timers.back().callback);
+    _timers.pop_back();
+    // May add timers itself, so the heap is consistent before it runs
+    callback();
+  }
+}
+
+std::vector<PollerEventData> EventLoop::spin() {
+  if (_busyPoll.count() == 0)
+    return {};
+  if (_spinSkipped < _spinSkip) {
+    ++_spinSkipped;
+    return {};
+  }
+  _spinSkipped = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + _busyPoll;
+  if (!_timers.empty())
+    deadline = std::min(deadline, _timers.front().deadline);
+  // Spinning is waiting as well, however busy the thread looks
+  auto now = start;
+  do {
+    auto events = _poller.poll(0);
+    now = std::chrono::steady_clock::now();
+    if (!events.empty()) {
+      _idleTicks.fetch_add((now - start).count(), std::memory_order_relaxed);
+      _spinSkip = 0;
+      return events;
+    }
+  } while (_running.load(std::memory_order_relaxed) && now < deadline);
+  _idleTicks.fetch_add((now - start).count(), std::memory_order_relaxed);
+
+  // Nothing came within the budget: spin on fewer and fewer wakeups while
+  // the load stays low
+  _spinSkip = std::min(_spinSkip * 2 + 1, MAX_SPIN_SKIP);
+  return {};
+}
+
+std::chrono::nanoseconds EventLoop::idle_time() const {
+  using Clock = std::chrono::steady_clock;
+  Clock::rep since = _waitingSince.load(std::memory_order_relaxed);
+  Clock::duration idle(_idleTicks.load(std::memory_order_relaxed));
+  if (since != 0)
+    idle += std::max(Clock::now().time_since_epoch() - Clock::duration(since),
+                     Clock::duration::zero());
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(idle);
+}
+
+int EventLoop::poll_timeout() const {
+  // Nothing to wake up for but events, posted tasks and stop()
+  if (_timers.empty())
+    return -1;
+  auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+      _timers.front().deadline - std::chrono::steady_clock::now());
+  return static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(
+      wait.count(), 0, std::numeric_limits<int>::max()));
+}
+
+void EventLoop::wake() {
+  std::uint64_t one = 1;
+  ssize_t written = ::write(_wakeupWriteFd, &one, sizeof(one));
+  (void)written; // A full pipe or counter already means a pending wakeup
+}
+
+void EventLoop::post(Task task) {
+  auto *node = new PostedTask{std::move(task)};
+  // Ordered before the task can run by the release below
+  _posting.fetch_add(1, std::memory_order_relaxed);
+  PostedTask *head = _posted.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!_posted.compare_exchange_weak(head, node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  // One wakeup per batch: the loop takes every task posted so far at once.
+  // The node may already be run and freed, so only head is looked at.
+  if (head == nullptr)
+    wake();
+  _posting.fetch_sub(1, std::memory_order_release);
+}
+
+void EventLoop::run_posted() {
+  // Drained first: a task posted after the exchange below wakes us again
+  std::uint64_t count;
+  while (::read(_wakeupFd, &count, sizeof(count)) > 0) {
+  }
+
+  // Newest first; reverse into posting order
+  PostedTask *node = _posted.exchange(nullptr, std::memory_order_acquire);
+  PostedTask *ordered = nullptr;
+  while (node) {
+    PostedTask *next = node->next;
+    node->next = ordered;
+    ordered = node;
+    node = next;
+  }
+  while (ordered) {
+    std::unique_ptr<PostedTask> current(std::exchange(ordered, ordered->next));
+    try {
+      current->task();
+    } catch (const std::exception &e) {
+      logging::Logger::error(std::string("EventLoop: posted task threw: ") +
+                             e.what());
+    }
+  }
+}
+
+void EventLoop::stop() {
+  _running.store(false);
+  wake(); // Stops a loop blocked in poll() right away
+}
 
 } // namespace fion::network
@@ -3,6 +3,8 @@
 #include <arpa/inet.h>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -115,6 +117,22 @@ int Listener::acceptClient() {
   return client_fd;
 }
 
+bool Listener::waitForClient(int timeoutMs) {
+  if (!_is_listening)
+    return false;
+  pollfd listening{_listenFD, POLLIN, 0};
+  int ready = ::poll(&listening, 1, timeoutMs);
+  return ready > 0 && (listening.revents & POLLIN) &&
+         !(listening.revents & (POLLHUP | POLLERR | POLLNVAL));
+}
+
+void Listener::shutdown() {
+  // Wakes poll() and accept() on Linux; elsewhere the waiter's timeout
+  // does
+  if (_listenFD >= 0)
+    ::shutdown(_listenFD, SHUT_RDWR);
+}
+
 void Listener::close() {
   if (_listenFD >= 0) {
     ::close(_listenFD);
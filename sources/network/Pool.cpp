@@ -1,23 +1,76 @@
 #include "network/Pool.hpp"
 #include "Handler.hpp"
+#include "http/Range.hpp"
 #include "http/Request.hpp"
 #include "http/Response.hpp"
 #include "logging/Logger.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <sstream>
+#include <sys/socket.h>
 
 namespace fion::network {
-Pool::Pool(Router *router) : _router(router) {
+Pool::Pool(Router *router, const ServerOptions &options, ThreadPool *workers,
+           std::size_t index, AdmissionControl *admission)
+    : _router(router), _dispatch(nullptr), _workers(workers),
+      _placement(options.ioPlacement), _index(index),
+      _routeCacheCapacity(options.routeCacheCapacity), _admission(admission),
+      _socketBusyPoll(static_cast<int>(options.socketBusyPoll.count())) {
+  if (options.queueDelayTarget.count() > 0)
+    _delay = std::make_unique<QueueDelayController>(
+        options.queueDelayTarget, options.queueDelayInterval);
+  _loop.set_busy_poll(options.busyPollBudget);
+  // Coroutine handlers offload to the same workers as offloaded routes
+  _loop.set_workers(workers);
   // Set up the event callback
   _loop.set_event_callback(
       [this](int fd, uint32_t events) { handle_client_event(fd, events); });
 }
 
+Pool::Pool(DispatchFunction dispatch, const ServerOptions &options,
+           std::size_t index, AdmissionControl *admission)
+    : _router(nullptr), _dispatch(dispatch), _workers(nullptr),
+      _placement(options.ioPlacement), _index(index),
+      _routeCacheCapacity(0), _admission(admission),
+      _socketBusyPoll(static_cast<int>(options.socketBusyPoll.count())) {
+  if (options.queueDelayTarget.count() > 0)
+    _delay = std::make_unique<QueueDelayController>(
+        options.queueDelayTarget, options.queueDelayInterval);
+  _loop.set_busy_poll(options.busyPollBudget);
+  _loop.set_event_callback(
+      [this](int fd, uint32_t events) { handle_client_event(fd, events); });
+}
+
 Pool::~Pool() { stop(); }
 
 void Pool::run() {
   logging::Logger::info("Pool: starting event loop thread");
-  _thread = std::thread([this]() { _loop.run(); });
+  std::promise<void> ready;
+  std::future<void> started = ready.get_future();
+  _thread = std::thread([this, ready = std::move(ready)]() mutable {
+    apply_placement(_placement, _index);
+    // Allocated here so first touch puts them on this thread's node
+    _routeCache.resize(_routeCacheCapacity);
+    if (_router) {
+      _spareRequest = std::make_unique<http::Request>();
+      _spareResponse = std::make_unique<http::Response>();
+    }
+    // Signalled from inside run(), so a stop() right after start() is not
+    // lost
+    _loop.post([&ready]() { ready.set_value(); });
+    _loop.run();
+    // Nothing resumes these anymore: their timers, watchers and posted
+    // resumptions went with the loop
+    if (_async.size() > 0)
+      logging::Logger::info("Pool: cancelling " +
+                            std::to_string(_async.size()) +
+                            " suspended async requests");
+    _async.cancel_all();
+  });
+  started.wait();
 }
 
 void Pool::stop() {
@@ -29,14 +82,67 @@ void Pool::stop() {
 }
 
 void Pool::addClient(int fd) {
-  _connectionPool.addClient(fd);
+  // Counted right away so the accept thread balances on it
+  _incoming.fetch_add(1, std::memory_order_relaxed);
+  _loop.post([this, fd]() {
+    // On the loop's thread: the client's buffers are allocated here and
+    // only this thread touches the poller
+    _connectionPool.addClient(fd);
+    _incoming.fetch_sub(1, std::memory_order_relaxed);
+    if (_socketBusyPoll > 0)
+      enable_busy_poll(fd);
+
+    // Add the client socket to the event loop for reading
+    uint32_t events = static_cast<uint32_t>(PollerEvent::READ) |
+                      static_cast<uint32_t>(PollerEvent::EDGE_TRIGGERED);
+    _loop.get_poller().addFD(fd, events);
+    logging::Logger::debug("Pool: added client fd=" + std::to_string(fd) +
+                           ", events=READ|EDGE");
+  });
+}
+
+void Pool::enable_busy_poll(int fd) {
+#ifdef SO_BUSY_POLL
+  if (::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &_socketBusyPoll,
+                   sizeof(_socketBusyPoll)) < 0) {
+    logging::Logger::debug("Pool: SO_BUSY_POLL refused for fd=" +
+                           std::to_string(fd) + ": " + std::strerror(errno));
+    return;
+  }
+#ifdef SO_PREFER_BUSY_POLL
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &on, sizeof(on));
+#endif
+#else
+  (void)fd;
+#endif
+}
+
+void Pool::close_client(int fd) {
+  _loop.get_poller().removeFD(fd);
+  _connectionPool.removeClient(fd);
+  if (_admission)
+    _admission->release_connection();
+}
+
+void Pool::close_all_clients() {
+  _loop.post([this]() {
+    std::vector<int> fds = _connectionPool.getClientFds();
+    for (int fd : fds)
+      close_client(fd);
+    logging::Logger::info("Pool: closed " + std::to_string(fds.size()) +
+                          " remaining connections");
+  });
+}
 
-  // Add the client socket to the event loop for reading
-  uint32_t events = static_cast<uint32_t>(PollerEvent::READ) |
-                    static_cast<uint32_t>(PollerEvent::EDGE_TRIGGERED);
-  _loop.get_poller().addFD(fd, events);
-  logging::Logger::debug("Pool: added client fd=" + std::to_string(fd) +
-                         ", events=READ|EDGE");
+void Pool::reject_request(Client *client) {
+  // Without the server's admission control there is no 503 to send
+  if (_admission && _admission->action() == OverloadAction::REJECT)
+    client->prepare_raw(_admission->rejection());
+  else
+    client->clear_response_buffer();
+  logging::Logger::debug("Pool: fd=" + std::to_string(client->get_fd()) +
+                         " rejected; over capacity");
 }
 
 void Pool::handle_client_event(int fd, uint32_t events) {
@@ -49,11 +155,14 @@ void Pool::handle_client_event(int fd, uint32_t events) {
                 static_cast<uint32_t>(PollerEvent::HANGUP))) {
     logging::Logger::warning("Pool: client fd=" + std::to_string(fd) +
                              " error/hangup; closing");
-    _loop.get_poller().removeFD(fd);
-    _connectionPool.removeClient(fd);
+    close_client(fd);
     return;
   }
 
+  // A request is already running on a worker; its response comes first
+  if (client->get_state() == ClientState::PROCESSING)
+    return;
+
   // Handle read events
   if (events & static_cast<uint32_t>(PollerEvent::READ)) {
     ssize_t bytes_read = client->readRequest();
@@ -64,8 +173,7 @@ void Pool::handle_client_event(int fd, uint32_t events) {
       // Connection closed or error
       logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
                              " read <= 0; closing");
-      _loop.get_poller().removeFD(fd);
-      _connectionPool.removeClient(fd);
+      close_client(fd);
       return;
     }
 
@@ -74,39 +182,85 @@ void Pool::handle_client_event(int fd, uint32_t events) {
       logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
                              " request ready; processing");
       client->set_state(ClientState::PROCESSING);
-      process_request(client);
-
-      // Try to write immediately
-      ssize_t bytes_sent = client->writeResponse();
-      logging::Logger::debug(
-          "Pool: fd=" + std::to_string(fd) +
-          " immediate write bytes=" + std::to_string(bytes_sent));
-
-      if (bytes_sent < 0) {
-        // Error sending
-        logging::Logger::error("Pool: fd=" + std::to_string(fd) +
-                               " write error; closing");
-        _loop.get_poller().removeFD(fd);
-        _connectionPool.removeClient(fd);
-        return;
+      if (process_request(client)) {
+        client->set_state(ClientState::WRITING_RESPONSE);
+        flush_response(client);
       }
-
-      // Response sent, close connection (HTTP/1.0 style for now)
-      logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
-                             " response sent; closing connection");
-      _loop.get_poller().removeFD(fd);
-      _connectionPool.removeClient(fd);
     } else {
       logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
                              " request incomplete; waiting for more data");
     }
+    return;
   }
 
-  // Handle write events (if we ever need them for async writes)
-  // For now, we write immediately after processing
+  // Handle write events: continue a response the socket could not take at once
+  if ((events & static_cast<uint32_t>(PollerEvent::WRITE)) &&
+      client->get_state() == ClientState::WRITING_RESPONSE) {
+    flush_response(client);
+  }
+}
+
+void Pool::bind_stream(Client *client, http::BodyWriter &writer) {
+  int fd = client->get_fd();
+  // Weak, so a writer kept by its producer does not keep the client open
+  std::weak_ptr<Client> weak = _connectionPool.getSharedClient(fd);
+  writer.set_resume_callback([this, fd, weak]() {
+    // Runs on the producer's thread, possibly from inside the pump of a
+    // flush in progress: the flush itself always waits for the loop
+    _loop.post([this, fd, weak]() {
+      auto shared = weak.lock();
+      // The connection may have been closed while the producer was busy;
+      // held, the client cannot be mistaken for one reusing its fd
+      if (shared && _connectionPool.getClient(fd) == shared.get() &&
+          shared->get_state() == ClientState::WRITING_RESPONSE)
+        flush_response(shared.get());
+    });
+  });
+}
+
+void Pool::flush_response(Client *client) {
+  int fd = client->get_fd();
+  ssize_t bytes_sent = client->writeResponse();
+  logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
+                         " write bytes=" + std::to_string(bytes_sent));
+
+  if (bytes_sent < 0) {
+    // Error sending
+    logging::Logger::error("Pool: fd=" + std::to_string(fd) +
+                           " write error; closing");
+    close_client(fd);
+    return;
+  }
+
+  if (client->is_waiting_for_stream()) {
+    // The stream's resume callback flushes again once it has data
+    return;
+  }
+
+  if (client->has_pending_response()) {
+    // Socket buffer is full; resume when it becomes writable again
+    uint32_t events = static_cast<uint32_t>(PollerEvent::WRITE) |
+                      static_cast<uint32_t>(PollerEvent::EDGE_TRIGGERED);
+    _loop.get_poller().modify_fd(fd, events);
+    logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
+                           " response pending; waiting for WRITE");
+    return;
+  }
+
+  // Response sent, close connection (HTTP/1.0 style for now)
+  logging::Logger::debug("Pool: fd=" + std::to_string(fd) +
+                         " response sent; closing connection");
+  close_client(fd);
 }
 
-void Pool::process_request(Client *client) {
+bool Pool::process_request(Client *client) {
+  // Shed before parsing when the loop kept the request waiting too long
+  if (_delay &&
+      !_delay->admit(std::chrono::steady_clock::now() - _loop.ready_since())) {
+    reject_request(client);
+    return true;
+  }
+
   try {
     auto request_data = std::string(client->get_request_data());
 
@@ -120,7 +274,7 @@ void Pool::process_request(Client *client) {
       response.setBody("Bad Request");
       client->prepare_response(response);
       logging::Logger::warning("Pool: invalid request (no start line)");
-      return;
+      return true;
     }
 
     std::string start_line = request_data.substr(0, first_crlf);
@@ -132,69 +286,92 @@ void Pool::process_request(Client *client) {
       response.setBody("Bad Request");
       client->prepare_response(response);
       logging::Logger::warning("Pool: invalid request (no headers end)");
-      return;
+      return true;
     }
 
     std::string headers =
         request_data.substr(first_crlf + 2, headers_end - first_crlf - 2);
     std::string body = request_data.substr(headers_end + 4);
 
-    // Create request object
-    http::Request request(start_line, headers, body);
+    // Create request object, reusing the previous one when its handler
+    // left it with us; it stays at this address until the handler releases
+    // it, so the router's parameter views into its path hold
+    std::unique_ptr<http::Request> request = std::move(_spareRequest);
+    if (request)
+      request->parse(start_line, headers, body);
+    else
+      request = std::make_unique<http::Request>(start_line, headers, body);
 
     // Route to handler
-    auto url = request.getURL();
-    std::string path = url.getPathToResource();
-
-    // Convert method to string for routing
-    std::string method;
-    switch (request.getMethod()) {
-    case http::Method::GET:
-      method = "GET";
-      break;
-    case http::Method::POST:
-      method = "POST";
-      break;
-    case http::Method::PUT:
-      method = "PUT";
-      break;
-    case http::Method::DELETE:
-      method = "DELETE";
-      break;
-    default:
-      method = "GET";
-      break;
-    }
+    const std::string path = request->getPath();
 
-    logging::Logger::info("Pool: routing " + method + " " + path);
+    const http::Method method = request->getMethod();
+    logging::Logger::info("Pool: routing " + http::methodToString(method) +
+                          " " + path);
 
-    std::map<std::string, std::string> params;
-    std::vector<std::function<void(std::unique_ptr<http::Request>&)>> middleware;
-    auto handler = _router->findRoute(path, method, params, middleware);
+    // Keep the range headers: the request is handed over to the handler
+    std::string range;
+    std::string ifRange;
+    if (method == http::Method::GET) {
+      const auto &requestHeaders = request->getHeaders();
+      range = requestHeaders.get("Range", "");
+      ifRange = requestHeaders.get("If-Range", "");
+    }
 
-    if (handler) {
-      // Attach params to request (if needed)
-      auto reqPtr = std::make_unique<http::Request>(request);
-      // Optionally: add a method to Request to set params, or use headers for now
-      for (const auto& kv : params) {
-        reqPtr->getHeaders().set("x-param-" + kv.first, kv.second);
+    std::unique_ptr<http::Response> response;
+    if (_dispatch) {
+      // Statically dispatched table: routing and middleware are inlined
+      response = _dispatch(std::move(request));
+    } else if (Router::RouteMatch match;
+               _routeCache.match(*_router, method, request->getPath(), match)) {
+      const Router::RouteTarget &target = *match.target;
+      // Shed before doing any work for the request
+      Bulkhead::Permit permit;
+      if (target.bulkhead && !Bulkhead::try_acquire(target.bulkhead, permit)) {
+        if (_admission)
+          _admission->count_rejected_request();
+        reject_request(client);
+        _spareRequest = std::move(request);
+        return true;
+      }
+      request->setParams(&target.paramKeys, match.params.values.data(),
+                         match.params.count);
+      if (target.pipeline.is_async()) {
+        // Runs until its first suspension, then resumes from the loop
+        serve_async(_connectionPool.getSharedClient(client->get_fd()), target,
+                    EpochReclaimer::instance().detach(std::move(match.guard)),
+                    std::move(request), std::move(range), std::move(ifRange),
+                    std::move(permit))
+            .detach(_async);
+        return false;
       }
-      // Run middleware
-      for (auto& mw : middleware) {
-        mw(reqPtr);
+      if (target.execution == ExecutionMode::OFFLOAD && _workers) {
+        if (_admission && !_admission->admit_task()) {
+          reject_request(client);
+          _spareRequest = std::move(request);
+          return true;
+        }
+        if (offload_request(client, target, std::move(match.guard),
+                            std::move(request), std::move(range),
+                            std::move(ifRange), std::move(permit)))
+          return false;
+        // The worker pool is stopping and dropped the request
+        if (_admission)
+          _admission->task_started();
+        reject_request(client);
+        return true;
       }
-      auto response = handler->handle(std::move(reqPtr));
-      response->setHeader("Connection", "close");
-      client->prepare_response(*response);
-      logging::Logger::debug("Pool: handler produced response");
+      // Middleware, handler and hooks, composed when the route was added;
+      // a PooledHandler borrows the request and the spare response
+      response = target.pipeline.run(request, _spareResponse);
     } else {
-      http::Response response;
-      response.setStatusCode(http::StatusCode::NOT_FOUND);
-      response.setBody("Not Found");
-      response.setHeader("Connection", "close");
-      client->prepare_response(response);
-      logging::Logger::info("Pool: no route found for " + method + " " + path);
+      logging::Logger::info("Pool: no route found for " +
+                            http::methodToString(method) + " " + path);
     }
+    if (request)
+      _spareRequest = std::move(request); // Not taken by a handler
+
+    finish_response(client, method, range, ifRange, std::move(response));
   } catch (const std::exception &e) {
     // Error processing request
     http::Response response;
@@ -205,6 +382,171 @@ void Pool::process_request(Client *client) {
     logging::Logger::error(std::string("Pool: exception during processing: ") +
                            e.what());
   }
+  return true;
+}
+
+bool Pool::offload_request(Client *client, const Router::RouteTarget &target,
+                           EpochReclaimer::Guard guard,
+                           std::unique_ptr<http::Request> request,
+                           std::string range, std::string ifRange,
+                           Bulkhead::Permit permit) {
+  // Everything the request needs until its response is written; created
+  // and destroyed on this pool's thread
+  struct Offloaded {
+    InFlight inFlight; ///< Released last, once the loop is done with it
+    std::shared_ptr<Client> client;
+    EpochReclaimer::Guard guard;
+    Bulkhead::Permit permit;
+    std::unique_ptr<http::Request> request;
+    std::unique_ptr<http::Response> response;
+    http::Method method;
+    std::string range;
+    std::string ifRange;
+    std::string error; ///< Set if the pipeline threw
+    bool shed = false; ///< Waited too long for a worker; not run
+    std::chrono::steady_clock::time_point queuedAt;
+  };
+
+  auto offloaded = std::make_unique<Offloaded>();
+  offloaded->inFlight = InFlight(*this);
+  offloaded->client = _connectionPool.getSharedClient(client->get_fd());
+  // Overlapping requests would keep this thread's record pinned
+  offloaded->guard = EpochReclaimer::instance().detach(std::move(guard));
+  offloaded->permit = std::move(permit);
+  offloaded->method = request->getMethod();
+  offloaded->request = std::move(request);
+  offloaded->range = std::move(range);
+  offloaded->ifRange = std::move(ifRange);
+  if (_admission && _admission->measures_task_delay())
+    offloaded->queuedAt = std::chrono::steady_clock::now();
+
+  logging::Logger::debug("Pool: fd=" + std::to_string(client->get_fd()) +
+                         " offloading to the worker pool");
+  return _workers->enqueue([this, &target,
+                            offloaded = std::move(offloaded)]() mutable {
+    if (_admission) {
+      _admission->task_started();
+      if (_admission->measures_task_delay())
+        offloaded->shed = !_admission->admit_task_delay(
+            std::chrono::steady_clock::now() - offloaded->queuedAt);
+    }
+    if (!offloaded->shed) {
+      try {
+        offloaded->response =
+            target.pipeline.run(std::move(offloaded->request));
+      } catch (const std::exception &e) {
+        offloaded->error = e.what();
+      }
+    }
+    offloaded->permit.release(); // The route's work is done
+
+    _loop.post([this, offloaded = std::move(offloaded)]() {
+      Client *client = offloaded->client.get();
+      if (!offloaded->shed) {
+        complete_request(client, offloaded->method, offloaded->range,
+                         offloaded->ifRange, std::move(offloaded->response),
+                         offloaded->error);
+      } else if (_connectionPool.getClient(client->get_fd()) == client) {
+        reject_request(client);
+        client->set_state(ClientState::WRITING_RESPONSE);
+        flush_response(client);
+      }
+    });
+  });
+}
+
+AsyncTask<void> Pool::serve_async(std::shared_ptr<Client> client,
+                                  const Router::RouteTarget &target,
+                                  [[maybe_unused]] EpochReclaimer::Guard guard,
+                                  std::unique_ptr<http::Request> request,
+                                  std::string range, std::string ifRange,
+                                  Bulkhead::Permit permit) {
+  // guard is never read: held by the frame, it keeps the route table that
+  // target points into alive until the coroutine is done
+  InFlight inFlight(*this);
+  http::Method method = request->getMethod();
+  std::unique_ptr<http::Response> response;
+  std::string error;
+  try {
+    response = co_await target.pipeline.run_async(std::move(request));
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+  permit.release();
+  // Back on this pool's thread, whatever the handler awaited
+  complete_request(client.get(), method, range, ifRange, std::move(response),
+                   error);
+}
+
+void Pool::complete_request(Client *client, http::Method method,
+                            const std::string &range,
+                            const std::string &ifRange,
+                            std::unique_ptr<http::Response> response,
+                            const std::string &error) {
+  // The connection may have been closed while the handler ran
+  if (_connectionPool.getClient(client->get_fd()) != client)
+    return;
+
+  std::string failure = error;
+  if (failure.empty()) {
+    try {
+      finish_response(client, method, range, ifRange, std::move(response));
+    } catch (const std::exception &e) {
+      failure = e.what();
+    }
+  }
+  if (!failure.empty()) {
+    http::Response response;
+    response.setStatusCode(http::StatusCode::INTERNAL_SERVER_ERROR);
+    response.setBody("Internal Server Error");
+    response.setHeader("Connection", "close");
+    client->prepare_response(response);
+    logging::Logger::error("Pool: exception during processing: " + failure);
+  }
+  client->set_state(ClientState::WRITING_RESPONSE);
+  flush_response(client);
+}
+
+void Pool::finish_response(Client *client, http::Method method,
+                           const std::string &range, const std::string &ifRange,
+                           std::unique_ptr<http::Response> response) {
+  if (!response) {
+    http::Response notFound;
+    notFound.setStatusCode(http::StatusCode::NOT_FOUND);
+    notFound.setBody("Not Found");
+    notFound.setHeader("Connection", "close");
+    client->prepare_response(notFound);
+    return;
+  }
+
+  response->setHeader("Connection", "close");
+  bool bodiless = false;
+  if (method == http::Method::HEAD) {
+    // Same headers as GET, but the body is never sent
+    http::Body body = response->releaseBody();
+    auto size = body.size();
+    const auto &headers = response->getHeaders();
+    bool framed =
+        headers.has("Content-Length") || headers.has("Transfer-Encoding");
+    if (size && !framed) {
+      response->setHeader("Content-Length", std::to_string(*size));
+    } else if (!size && !framed) {
+      // A streamed or generated body has no length to announce: frame it
+      // as GET would (chunked, or until the close on HTTP/1.0), never as
+      // an empty one
+      if (response->getVersion() == http::Version::HTTP_1_1)
+        response->setHeader("Transfer-Encoding", "chunked");
+      bodiless = true;
+    }
+  }
+  if (!range.empty() && http::applyRange(*response, range, ifRange))
+    logging::Logger::debug("Pool: serving range " + range);
+  if (response->getBody().kind() == http::BodyKind::STREAM)
+    bind_stream(client, *response->getBody().asStream());
+  client->take_response(*response, bodiless);
+  response->reset(); // Serialized already, the header entries are reused
+  _spareResponse = std::move(response);
+  logging::Logger::debug("Pool: handler produced response");
 }
 
 } // namespace fion::network
@@ -1,6 +1,8 @@
 #include "network/PoolManager.hpp"
 #include "logging/Logger.hpp"
+#include <algorithm>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace fion::network {
 PoolManager::PoolManager() : _nextPoolIndex(0) {}
@@ -14,15 +16,13 @@ void PoolManager::add_pool(std::unique_ptr<Pool> pool) {
                          std::to_string(_pools.size()));
 }
 
-Pool *PoolManager::get_pool() {
-  std::lock_guard<std::mutex> lock(_mutex);
-
+Pool *PoolManager::next_pool() {
   if (_pools.empty())
     return nullptr;
 
-  // Round-robin selection
+  // Round-robin selection; the count changes with autoscaling
   size_t index = _nextPoolIndex % _pools.size();
-  _nextPoolIndex = (_nextPoolIndex + 1) % _pools.size();
+  _nextPoolIndex = (index + 1) % _pools.size();
 
   auto *selected = _pools[index].get();
   logging::Logger::debug("PoolManager: selected pool index=" +
@@ -30,15 +30,33 @@ Pool *PoolManager::get_pool() {
   return selected;
 }
 
-void PoolManager::distribute_client(int fd) {
-  Pool *pool = get_pool();
-  if (pool) {
-    pool->addClient(fd);
-    logging::Logger::debug("PoolManager: distributed client fd=" +
-                           std::to_string(fd));
-  } else {
+Pool *PoolManager::get_pool() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return next_pool();
+}
+
+bool PoolManager::distribute_client(int fd, std::size_t maxPerPool) {
+  // Held throughout, so the pool chosen cannot be retired and destroyed
+  // before it has the client
+  std::lock_guard<std::mutex> lock(_mutex);
+  Pool *pool = next_pool();
+  if (!pool)
     throw std::runtime_error("No pools available to distribute client");
+
+  if (maxPerPool > 0) {
+    // Try the others in turn if this one is full; the counts may lag
+    // behind the pools' threads, so the cap is approximate
+    std::size_t tries = _pools.size();
+    while (pool->get_client_count() >= maxPerPool) {
+      if (--tries == 0)
+        return false;
+      pool = next_pool();
+    }
   }
+  pool->addClient(fd);
+  logging::Logger::debug("PoolManager: distributed client fd=" +
+                         std::to_string(fd));
+  return true;
 }
 
 void PoolManager::start_all() {
@@ -50,11 +68,214 @@ void PoolManager::start_all() {
                         std::to_string(_pools.size()));
 }
 
+void PoolManager::validate_scaling(const PoolScaling &scaling) {
+  if (scaling.maxPools == 0)
+    return; // Disabled
+  if (scaling.minPools == 0 || scaling.minPools > scaling.maxPools)
+    throw std::invalid_argument(
+        "Pool scaling needs 1 <= minPools <= maxPools");
+  if (!(scaling.scaleDownUtilization < scaling.scaleUpUtilization) ||
+      scaling.scaleDownUtilization < 0 || scaling.scaleUpUtilization > 1)
+    throw std::invalid_argument("Pool scaling needs 0 <= "
+                                "scaleDownUtilization < scaleUpUtilization "
+                                "<= 1");
+  if (scaling.interval.count() <= 0 || scaling.samples == 0)
+    throw std::invalid_argument(
+        "Pool scaling needs a positive interval and sample count");
+}
+
+void PoolManager::start_autoscaling(const PoolScaling &scaling,
+                                    PoolFactory factory) {
+  validate_scaling(scaling);
+  if (scaling.maxPools == 0 || _scaler.joinable())
+    return; // Disabled or already started
+
+  _scaling = scaling;
+  _factory = std::move(factory);
+  {
+    std::lock_guard<std::mutex> lock(_scalerMutex);
+    _scalerStop = false;
+  }
+  _scaler = std::thread([this]() { autoscale_loop(); });
+  logging::Logger::info("PoolManager: autoscaling between " +
+                        std::to_string(scaling.minPools) + " and " +
+                        std::to_string(scaling.maxPools) + " pools");
+}
+
+void PoolManager::autoscale_loop() {
+  using Clock = std::chrono::steady_clock;
+  struct Sample {
+    Clock::time_point at;
+    std::chrono::nanoseconds idle;
+  };
+  // Previous sample of each pool; a pool's first one only starts its own
+  std::unordered_map<const Pool *, Sample> samples;
+  unsigned high = 0;
+  unsigned low = 0;
+
+  std::unique_lock<std::mutex> wait(_scalerMutex);
+  while (!_scalerWakeup.wait_for(wait, _scaling.interval,
+                                 [this]() { return _scalerStop; })) {
+    wait.unlock();
+    reap_draining();
+
+    double total = 0;
+    std::size_t measured = 0;
+    std::size_t pools;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      pools = _pools.size();
+      std::unordered_map<const Pool *, Sample> current;
+      for (const auto &pool : _pools) {
+        Sample sample{Clock::now(), pool->get_idle_time()};
+        if (auto previous = samples.find(pool.get());
+            previous != samples.end() && sample.at > previous->second.at) {
+          double idle = std::chrono::duration<double>(
+                            sample.idle - previous->second.idle)
+                            .count() /
+                        std::chrono::duration<double>(
+                            sample.at - previous->second.at)
+                            .count();
+          total += 1 - std::clamp(idle, 0.0, 1.0);
+          ++measured;
+        }
+        current.emplace(pool.get(), sample);
+      }
+      samples = std::move(current);
+    }
+
+    if (measured > 0) {
+      double utilization = total / static_cast<double>(measured);
+      _utilization.store(utilization, std::memory_order_relaxed);
+      high = utilization > _scaling.scaleUpUtilization ? high + 1 : 0;
+      low = utilization < _scaling.scaleDownUtilization ? low + 1 : 0;
+
+      if (high >= _scaling.samples && pools < _scaling.maxPools) {
+        scale_up();
+        high = 0;
+      } else if (low >= _scaling.samples && pools > _scaling.minPools &&
+                 // Would the pools left be busy enough to add one back?
+                 utilization * static_cast<double>(pools) /
+                         static_cast<double>(pools - 1) <
+                     _scaling.scaleUpUtilization) {
+        scale_down();
+        low = 0;
+      }
+    }
+    wait.lock();
+  }
+}
+
+void PoolManager::scale_up() {
+  std::size_t index = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::size_t> used;
+    for (const auto &pool : _pools)
+      used.push_back(pool->get_index());
+    for (const auto &draining : _draining)
+      used.push_back(draining.pool->get_index());
+    while (std::find(used.begin(), used.end(), index) != used.end())
+      ++index;
+  }
+
+  try {
+    // Started outside the lock: the accept thread keeps distributing
+    std::unique_ptr<Pool> pool = _factory(index);
+    pool->run();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pools.push_back(std::move(pool));
+    logging::Logger::info("PoolManager: added pool index=" +
+                          std::to_string(index) +
+                          ", total=" + std::to_string(_pools.size()));
+  } catch (const std::exception &e) {
+    logging::Logger::error(std::string("PoolManager: adding a pool failed: ") +
+                           e.what());
+    return;
+  }
+  _added.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PoolManager::scale_down() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_pools.size() < 2)
+    return;
+  // The emptiest pool drains first
+  auto retired = std::min_element(
+      _pools.begin(), _pools.end(), [](const auto &a, const auto &b) {
+        return a->get_client_count() < b->get_client_count();
+      });
+  logging::Logger::info(
+      "PoolManager: retiring pool index=" +
+      std::to_string((*retired)->get_index()) + " with " +
+      std::to_string((*retired)->get_client_count()) + " connections");
+  _draining.push_back(
+      Draining{std::move(*retired), std::chrono::steady_clock::now()});
+  _pools.erase(retired);
+}
+
+void PoolManager::reap_draining() {
+  std::vector<std::unique_ptr<Pool>> drained;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = _draining.begin(); it != _draining.end();) {
+      if (it->pool->is_drained()) {
+        drained.push_back(std::move(it->pool));
+        it = _draining.erase(it);
+        continue;
+      }
+      if (!it->closing && now - it->since >= _scaling.drainTimeout) {
+        it->pool->close_all_clients();
+        it->closing = true;
+      }
+      ++it;
+    }
+  }
+  // Out of the lock: joining a loop may take a moment
+  for (auto &pool : drained) {
+    logging::Logger::info("PoolManager: stopping drained pool index=" +
+                          std::to_string(pool->get_index()));
+    pool->stop();
+    pool.reset();
+    _retired.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+PoolStats PoolManager::stats() const {
+  PoolStats stats;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.pools = _pools.size();
+    stats.draining = _draining.size();
+  }
+  stats.utilization = _utilization.load(std::memory_order_relaxed);
+  stats.added = _added.load(std::memory_order_relaxed);
+  stats.retired = _retired.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void PoolManager::stop_autoscaling() {
+  if (!_scaler.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(_scalerMutex);
+    _scalerStop = true;
+  }
+  _scalerWakeup.notify_all();
+  _scaler.join();
+}
+
 void PoolManager::stop_all() {
+  stop_autoscaling();
+
   std::lock_guard<std::mutex> lock(_mutex);
   for (auto &pool : _pools) {
     pool->stop();
   }
+  for (auto &draining : _draining) {
+    draining.pool->stop();
+  }
   logging::Logger::info("PoolManager: stopped all pools");
 }
 
@@ -0,0 +1,43 @@
+#include "network/QueueDelayController.hpp"
+
+namespace fion::network {
+QueueDelayController::QueueDelayController(std::chrono::milliseconds target,
+                                           std::chrono::milliseconds interval)
+    : _target(target), _interval(interval) {}
+
+bool QueueDelayController::admit(Clock::duration delay,
+                                 Clock::time_point now) {
+  _observed.fetch_add(1, std::memory_order_relaxed);
+  _lastDelay.store(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count(),
+      std::memory_order_relaxed);
+
+  Clock::rep ticks = now.time_since_epoch().count();
+  if (delay < _target) {
+    _firstAbove.store(0, std::memory_order_relaxed);
+    return true;
+  }
+  // A run starts here, or anew after a quiet spell; races between threads
+  // only move its start by a few requests
+  Clock::rep last = _lastAbove.exchange(ticks, std::memory_order_relaxed);
+  if (_firstAbove.load(std::memory_order_relaxed) == 0 ||
+      ticks - last > Clock::duration(_interval).count())
+    _firstAbove.store(ticks, std::memory_order_relaxed);
+  // A standing queue gets the short timeout, a burst the long one
+  Clock::duration timeout = overloaded(now) ? _target : _interval;
+  if (delay <= timeout)
+    return true;
+  _shed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+QueueDelayController::Stats QueueDelayController::stats(void) const {
+  Stats stats;
+  stats.overloaded = overloaded(Clock::now());
+  stats.observed = _observed.load(std::memory_order_relaxed);
+  stats.shed = _shed.load(std::memory_order_relaxed);
+  stats.lastDelay = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::nanoseconds(_lastDelay.load(std::memory_order_relaxed)));
+  return stats;
+}
+} // namespace fion::network
@@ -1,19 +1,49 @@
 #include "network/Server.hpp"
 #include "logging/Logger.hpp"
-#include <chrono>
+#include <algorithm>
 #include <thread>
+#include <vector>
 #include <unistd.h>
 
 namespace fion::network {
-Server::Server(Router *router) : _router(router), _running(false) {}
+Server::Server(Router *router)
+    : _router(router), _dispatch(nullptr), _running(false) {}
+
+Server::Server(DispatchFunction dispatch)
+    : _router(nullptr), _dispatch(dispatch), _running(false) {}
 
 Server::~Server() { stop(); }
 
 void Server::start(const std::string &host, std::uint16_t port,
                    std::size_t numThreads) {
+  ServerOptions options;
+  options.numThreads = numThreads;
+  start(host, port, options);
+}
+
+void Server::start(const std::string &host, std::uint16_t port,
+                   const ServerOptions &options) {
   if (_running.exchange(true))
     return; // Already running
 
+  try {
+    validate_placement(options.ioPlacement);
+    validate_placement(options.workerPlacement);
+    PoolManager::validate_scaling(options.poolScaling);
+  } catch (...) {
+    _running = false;
+    throw;
+  }
+
+  // Build the route table registered so far once; later changes are
+  // published as they are made
+  if (_router)
+    _router->commit();
+
+  // Kept after stop() so the counters stay readable
+  _admission = std::make_unique<AdmissionControl>(options);
+  _maxConnectionsPerPool = options.maxConnectionsPerPool;
+
   // Bind and listen
   _listener.bind(host, port);
   _listener.listen();
@@ -21,14 +51,28 @@ void Server::start(const std::string &host, std::uint16_t port,
   logging::Logger::info("Server listening on " + host + ":" +
                         std::to_string(port));
 
-  // Create I/O pools
-  for (std::size_t i = 0; i < numThreads; ++i) {
-    auto pool = std::make_unique<Pool>(_router);
-    _poolManager.add_pool(std::move(pool));
-  }
+  // Worker pool shared by the I/O pools for offloaded routes
+  if (!_dispatch && options.workerThreads > 0)
+    _workers = std::make_unique<ThreadPool>(options.workerThreads,
+                                            options.workerPlacement);
+
+  // Create I/O pools; autoscaling creates more the same way
+  PoolFactory factory = [this, options](std::size_t index) {
+    return _dispatch ? std::make_unique<Pool>(_dispatch, options, index,
+                                              _admission.get())
+                     : std::make_unique<Pool>(_router, options, _workers.get(),
+                                              index, _admission.get());
+  };
+  std::size_t numThreads = options.numThreads;
+  const PoolScaling &scaling = options.poolScaling;
+  if (scaling.maxPools > 0)
+    numThreads = std::clamp(numThreads, scaling.minPools, scaling.maxPools);
+  for (std::size_t i = 0; i < numThreads; ++i)
+    _poolManager.add_pool(factory(i));
 
   // Start all pools
   _poolManager.start_all();
+  _poolManager.start_autoscaling(scaling, std::move(factory));
 
   // Start accept thread
   _accept_thread = std::thread([this]() { accept_loop(); });
@@ -40,34 +84,81 @@ void Server::stop() {
 
   logging::Logger::info("Stopping server...");
 
-  // Stop accepting new connections
-  _listener.close();
-
-  // Wait for accept thread
+  // Stop accepting new connections; closed once the accept thread is done
+  // with the socket
+  _listener.shutdown();
   if (_accept_thread.joinable())
     _accept_thread.join();
+  _listener.close();
+
+  // No pool is added or retired from here on: the scaler's factory hands
+  // new pools the worker pool, which is shut down and reset below
+  _poolManager.stop_autoscaling();
+
+  // Finish offloaded requests first: their responses are posted to the
+  // pools' loops, which run them before stopping. The pools still hold the
+  // worker pool, so it is only destroyed once they stopped.
+  if (_workers)
+    _workers->shutdown();
 
   // Stop all pools
   _poolManager.stop_all();
+  _workers.reset();
 
   logging::Logger::info("Server stopped");
 }
 
+RouteCache::Stats Server::get_route_cache_stats() const {
+  RouteCache::Stats total;
+  _poolManager.for_each_pool([&total](const Pool &pool) {
+    RouteCache::Stats stats = pool.get_route_cache_stats();
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.entries += stats.entries;
+    total.capacity += stats.capacity;
+  });
+  return total;
+}
+
+PoolStats Server::get_pool_stats() const { return _poolManager.stats(); }
+
+AdmissionStats Server::get_admission_stats() const {
+  if (!_admission)
+    return AdmissionStats{};
+  std::vector<QueueDelayController::Stats> poolQueues;
+  _poolManager.for_each_pool([&poolQueues](const Pool &pool) {
+    if (auto delay = pool.get_queue_delay_stats())
+      poolQueues.push_back(*delay);
+  });
+  return _admission->stats(std::move(poolQueues));
+}
+
 void Server::accept_loop() {
   while (_running.load()) {
     int client_fd = _listener.acceptClient();
 
     if (client_fd >= 0) {
+      if (!_admission->admit_connection()) {
+        _admission->reject_connection(client_fd);
+        continue;
+      }
       try {
-        _poolManager.distribute_client(client_fd);
+        if (!_poolManager.distribute_client(client_fd,
+                                            _maxConnectionsPerPool)) {
+          _admission->release_connection();
+          _admission->count_rejected_connection();
+          _admission->reject_connection(client_fd);
+        }
       } catch (const std::exception &e) {
         logging::Logger::error(std::string("Failed to distribute client: ") +
                                e.what());
+        _admission->release_connection();
         ::close(client_fd);
       }
     } else {
-      // No connection available, sleep briefly
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      // Block until the next connection; stop() shuts the socket down to
+      // wake us, the timeout covers platforms where that does not
+      _listener.waitForClient(100);
     }
   }
 }
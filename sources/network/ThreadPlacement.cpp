@@ -0,0 +1,302 @@
+#include "network/ThreadPlacement.hpp"
+#include "logging/Logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fion::network {
+namespace {
+// Parse a kernel CPU list such as "0-3,8,10-11"
+std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n")
+      continue;
+    std::size_t dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first
+                                           : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    } catch (const std::exception &) {
+      return {};
+    }
+  }
+  return cpus;
+}
+
+std::string read_line(const std::string &path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// CPUs allowed by the cgroup quota of a directory and its ancestors, or 0
+// when none of them sets a quota
+double cgroup_quota(const std::string &root, std::string path, bool v2) {
+  double limit = 0;
+  while (true) {
+    std::string directory = root + path;
+    double quota = 0;
+    double period = 0;
+    if (v2) {
+      std::stringstream line(read_line(directory + "/cpu.max"));
+      std::string max;
+      if (line >> max >> period && max != "max")
+        quota = std::stod(max);
+    } else {
+      std::string quotaLine = read_line(directory + "/cpu.cfs_quota_us");
+      std::string periodLine = read_line(directory + "/cpu.cfs_period_us");
+      if (!quotaLine.empty() && !periodLine.empty()) {
+        quota = std::stod(quotaLine); // -1 without a quota
+        period = std::stod(periodLine);
+      }
+    }
+    if (quota > 0 && period > 0)
+      limit = limit > 0 ? std::min(limit, quota / period) : quota / period;
+
+    if (path.empty() || path == "/")
+      return limit;
+    std::size_t slash = path.rfind('/');
+    path = slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+  }
+}
+
+double cgroup_cpu_limit(void) {
+  std::ifstream cgroups("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(cgroups, line)) {
+    // "hierarchy-id:controllers:path"
+    std::size_t first = line.find(':');
+    std::size_t second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos)
+      continue;
+    std::string controllers = line.substr(first + 1, second - first - 1);
+    std::string path = line.substr(second + 1);
+
+    if (line.compare(0, first, "0") == 0 && controllers.empty()) {
+      if (double limit = cgroup_quota("/sys/fs/cgroup", path, true))
+        return limit;
+      continue;
+    }
+    std::stringstream list(controllers);
+    std::string controller;
+    while (std::getline(list, controller, ',')) {
+      if (controller != "cpu")
+        continue;
+      for (const char *root : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"}) {
+        if (double limit = cgroup_quota(root, path, false))
+          return limit;
+        // Inside a container the cgroup is often mounted as the root
+        if (double limit = cgroup_quota(root, "/", false))
+          return limit;
+      }
+    }
+  }
+  return 0;
+}
+
+std::string thread_name(const ThreadPlacement &placement, std::size_t index) {
+  std::string name = placement.name + "-" + std::to_string(index);
+  // Linux rejects names longer than 15 bytes; keep the index visible
+  if (name.size() > 15)
+    name = placement.name.substr(0, 15 - name.size() + placement.name.size()) +
+           "-" + std::to_string(index);
+  return name.substr(0, 15);
+}
+
+std::vector<int> placement_cpus(const ThreadPlacement &placement) {
+  if (!placement.cpus.empty())
+    return placement.cpus;
+
+  // All allowed CPUs, node by node
+  std::vector<int> allowed = allowed_cpus();
+  std::vector<int> ordered;
+  for (int node = 0; ordered.size() < allowed.size(); ++node) {
+    std::vector<int> local = numa_node_cpus(node);
+    if (local.empty() && node > 0 &&
+        !std::ifstream("/sys/devices/system/node/node" + std::to_string(node)))
+      break;
+    ordered.insert(ordered.end(), local.begin(), local.end());
+  }
+  // CPUs of no known node (or no NUMA information at all) go last
+  for (int cpu : allowed) {
+    if (std::find(ordered.begin(), ordered.end(), cpu) == ordered.end())
+      ordered.push_back(cpu);
+  }
+  return ordered;
+}
+
+#ifdef __linux__
+int native_policy(SchedulingPolicy policy) {
+  switch (policy) {
+  case SchedulingPolicy::BATCH:
+    return SCHED_BATCH;
+  case SchedulingPolicy::IDLE:
+    return SCHED_IDLE;
+  case SchedulingPolicy::FIFO:
+    return SCHED_FIFO;
+  case SchedulingPolicy::ROUND_ROBIN:
+    return SCHED_RR;
+  default:
+    return SCHED_OTHER;
+  }
+}
+#else
+int native_policy(SchedulingPolicy policy) {
+  switch (policy) {
+  case SchedulingPolicy::FIFO:
+    return SCHED_FIFO;
+  case SchedulingPolicy::ROUND_ROBIN:
+    return SCHED_RR;
+  default:
+    return SCHED_OTHER;
+  }
+}
+#endif
+
+void warn(const std::string &name, const std::string &what, int error) {
+  logging::Logger::warning("ThreadPlacement: " + name + ": cannot " + what +
+                           ": " + std::strerror(error));
+}
+} // namespace
+
+void apply_placement(const ThreadPlacement &placement, std::size_t index) {
+  std::string name =
+      placement.name.empty() ? "fion-" + std::to_string(index)
+                             : thread_name(placement, index);
+
+#ifdef __linux__
+  pthread_setname_np(pthread_self(), name.c_str());
+
+  if (placement.pin) {
+    std::vector<int> cpus = placement_cpus(placement);
+    if (!cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (placement.pinEach) {
+        CPU_SET(cpus[index % cpus.size()], &set);
+      } else {
+        for (int cpu : cpus)
+          CPU_SET(cpu, &set);
+      }
+      if (int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+        warn(name, "set CPU affinity", error);
+    }
+  }
+#else
+  pthread_setname_np(name.c_str());
+  if (placement.pin)
+    logging::Logger::debug("ThreadPlacement: CPU affinity is not supported "
+                           "on this platform");
+#endif
+
+  if (placement.policy != SchedulingPolicy::INHERIT) {
+    sched_param param{};
+    param.sched_priority = placement.priority;
+    if (int error = pthread_setschedparam(
+            pthread_self(), native_policy(placement.policy), &param))
+      warn(name, "set the scheduling policy", error);
+  }
+
+  if (placement.niceness) {
+#ifdef __linux__
+    // Per thread on Linux, where a thread is a process for setpriority()
+    auto thread = static_cast<id_t>(::syscall(SYS_gettid));
+    if (::setpriority(PRIO_PROCESS, thread, *placement.niceness) < 0)
+      warn(name, "set the niceness", errno);
+#else
+    logging::Logger::debug("ThreadPlacement: per-thread niceness is not "
+                           "supported on this platform");
+#endif
+  }
+
+  logging::Logger::debug("ThreadPlacement: configured thread " + name);
+}
+
+void validate_placement(const ThreadPlacement &placement) {
+  if (placement.pin && !placement.cpus.empty()) {
+    std::vector<int> allowed = allowed_cpus();
+    for (int cpu : placement.cpus) {
+      if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end())
+        throw std::invalid_argument("CPU " + std::to_string(cpu) +
+                                    " is not available to this process");
+    }
+  }
+  bool realtime = placement.policy == SchedulingPolicy::FIFO ||
+                  placement.policy == SchedulingPolicy::ROUND_ROBIN;
+  if (realtime && (placement.priority < 1 || placement.priority > 99))
+    throw std::invalid_argument(
+        "real-time scheduling needs a priority from 1 to 99");
+  if (!realtime && placement.policy != SchedulingPolicy::INHERIT &&
+      placement.priority != 0)
+    throw std::invalid_argument(
+        "priority only applies to real-time scheduling; use niceness");
+  if (placement.niceness &&
+      (*placement.niceness < -20 || *placement.niceness > 19))
+    throw std::invalid_argument("niceness must be from -20 to 19");
+}
+
+std::vector<int> allowed_cpus(void) {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set))
+        cpus.push_back(cpu);
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < count; ++cpu)
+      cpus.push_back(static_cast<int>(cpu));
+  }
+  return cpus;
+}
+
+std::vector<int> numa_node_cpus(int node) {
+  std::vector<int> local = parse_cpu_list(read_line(
+      "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+  std::vector<int> allowed = allowed_cpus();
+  std::vector<int> cpus;
+  for (int cpu : local) {
+    if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::size_t available_cpus(void) {
+  static const std::size_t count = [] {
+    std::size_t cpus = allowed_cpus().size();
+    double limit = cgroup_cpu_limit();
+    if (limit > 0)
+      cpus = std::min(cpus, static_cast<std::size_t>(std::ceil(limit)));
+    return std::max<std::size_t>(cpus, 1);
+  }();
+  return count;
+}
+
+} // namespace fion::network
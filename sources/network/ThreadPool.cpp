@@ -1,45 +1,315 @@
 #include "network/ThreadPool.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <utility>
+
 namespace fion::network {
-ThreadPool::ThreadPool(size_t numThreads) : _stop(false) {
+namespace {
+// Tasks a worker moves from the shared queue to its own deque at once
+constexpr std::size_t SHARED_BATCH = 32;
+
+struct CurrentWorker {
+  ThreadPool *pool = nullptr;
+  std::size_t index = 0;
+};
+
+thread_local CurrentWorker currentWorker;
+
+// One fork_join call, shared with its helper tasks: those may start after
+// the call returned, and then only find every chunk claimed
+struct ForkJoin {
+  std::size_t chunks;
+  void (*run)(void *, std::size_t);
+  void *context;
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> done{0};
+  std::atomic<bool> failed{false};
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  ForkJoin(std::size_t count, void (*function)(void *, std::size_t),
+           void *data)
+      : chunks(count), run(function), context(data) {}
+
+  void run_chunks(void) {
+    while (true) {
+      std::size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= chunks)
+        return;
+      if (!failed.load(std::memory_order_relaxed)) {
+        try {
+          run(context, chunk);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (!error)
+            error = std::current_exception();
+          failed.store(true, std::memory_order_relaxed);
+        }
+      }
+      if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks)
+        done.notify_all();
+    }
+  }
+};
+} // namespace
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : ThreadPool(numThreads, ThreadPlacement{.name = "fion-worker"}) {}
+
+ThreadPool::ThreadPool(size_t numThreads, ThreadPlacement placement)
+    : _placement(std::move(placement)), _stop(false) {
+  _workers.reserve(numThreads);
+  _idle.reserve(numThreads);
   for (size_t i = 0; i < numThreads; ++i) {
-    _threads.emplace_back([this]() { worker_loop(); });
+    _workers.push_back(std::make_unique<Worker>());
+    _workers.back()->random = 0x9E3779B97F4A7C15ULL * (i + 1);
   }
+  // Workers look at each other's deques, so all exist before any starts
+  for (size_t i = 0; i < numThreads; ++i)
+    _workers[i]->thread = std::thread([this, i]() { worker_loop(i); });
 }
 
-ThreadPool::~ThreadPool() {
+ThreadPool::~ThreadPool() { shutdown(); }
+
+void ThreadPool::shutdown() {
   {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> lock(_idleMutex);
     _stop = true;
   }
-  _cv.notify_all();
+  for (auto &worker : _workers)
+    worker->wakeup.notify_all();
 
-  for (auto &thread : _threads) {
-    if (thread.joinable())
-      thread.join();
+  // Workers only exit once no task is queued
+  for (auto &worker : _workers) {
+    if (worker->thread.joinable())
+      worker->thread.join();
   }
 }
 
-void ThreadPool::worker_loop() {
+void ThreadPool::worker_loop(std::size_t index) {
+  apply_placement(_placement, index);
+  currentWorker = {this, index};
+  Worker &self = *_workers[index];
+  Task task;
+  bool woken = false; // Counted as searching by whoever woke this worker
+
   while (true) {
-    std::function<void()> task;
+    if ((!woken && self.deque.pop(task)) || find_task(self, task, woken)) {
+      woken = false;
+      task();
+      task.reset();
+      continue;
+    }
+    if (!park(index, woken))
+      return;
+  }
+}
 
-    {
-      std::unique_lock<std::mutex> lock(_mutex);
-      _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+ThreadPool::Worker *ThreadPool::current_worker(void) const {
+  if (currentWorker.pool != this)
+    return nullptr;
+  return _workers[currentWorker.index].get();
+}
 
-      if (_stop && _tasks.empty())
-        return;
+bool ThreadPool::find_task(Worker &self, Task &task, bool counted) {
+  if (!counted)
+    _searching.fetch_add(1, std::memory_order_seq_cst);
+  bool found = take_shared(self, task) || steal(self, task);
+  // The last searcher to find work hands the search over to a parked
+  // worker if more is queued
+  if (_searching.fetch_sub(1, std::memory_order_seq_cst) == 1 && found &&
+      has_work())
+    notify(1);
+  return found;
+}
 
-      if (!_tasks.empty()) {
-        task = std::move(_tasks.front());
-        _tasks.pop();
-      }
+bool ThreadPool::take_shared(Worker &self, Task &task) {
+  if (_sharedCount.load(std::memory_order_relaxed) == 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(_sharedMutex);
+  if (_shared.empty())
+    return false;
+  task = std::move(_shared.front());
+  _shared.pop_front();
+  std::size_t taken = 1;
+
+  // Take a fair share of the rest, so other workers steal it from this
+  // deque instead of all contending on the shared lock
+  std::size_t share = std::min(_shared.size() / _workers.size(), SHARED_BATCH);
+  while (share-- > 0 && self.deque.push(_shared.front())) {
+    _shared.pop_front();
+    ++taken;
+  }
+  _sharedCount.fetch_sub(taken, std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::steal(Worker &self, Task &task) {
+  std::size_t count = _workers.size();
+  if (count < 2)
+    return false;
+
+  // xorshift64: victims are picked at random so thieves spread out
+  std::uint64_t &random = self.random;
+  random ^= random << 13;
+  random ^= random >> 7;
+  random ^= random << 17;
+  std::size_t start = random % count;
+
+  // A steal fails when another thief wins the race, so retry once before
+  // concluding the deques are empty
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (std::size_t i = 0; i < count; ++i) {
+      Worker &victim = *_workers[(start + i) % count];
+      if (&victim != &self && victim.deque.steal(task))
+        return true;
     }
+  }
+  return false;
+}
 
-    if (task)
-      task();
+bool ThreadPool::has_work(void) const {
+  if (_sharedCount.load(std::memory_order_seq_cst) > 0)
+    return true;
+  for (const auto &worker : _workers) {
+    if (worker->deque.size() > 0)
+      return true;
   }
+  return false;
+}
+
+bool ThreadPool::park(std::size_t index, bool &woken) {
+  Worker &self = *_workers[index];
+  std::unique_lock<std::mutex> lock(_idleMutex);
+
+  auto leave = [&]() {
+    _idle.erase(std::find(_idle.begin(), _idle.end(), index));
+    _idleCount.fetch_sub(1, std::memory_order_relaxed);
+  };
+
+  // Advertise as idle before the last look for work: a producer either
+  // sees this worker in the idle list or its task is seen here
+  self.notified = false;
+  woken = false;
+  _idle.push_back(index);
+  _idleCount.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (has_work()) {
+    leave();
+    return true;
+  }
+  if (_stop) {
+    leave();
+    return false;
+  }
+
+  self.wakeup.wait(lock, [&]() { return self.notified || _stop; });
+  // The notifier already removed this worker from the idle list
+  if (!self.notified)
+    leave();
+  woken = self.notified;
+  return true;
+}
+
+void ThreadPool::notify(std::size_t count) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (_idleCount.load(std::memory_order_relaxed) == 0)
+    return;
+  // A searching worker will find the task and wake the next one if needed
+  if (count == 1 && _searching.load(std::memory_order_relaxed) > 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(_idleMutex);
+  while (count-- > 0 && !_idle.empty()) {
+    Worker &worker = *_workers[_idle.back()];
+    _idle.pop_back();
+    _idleCount.fetch_sub(1, std::memory_order_relaxed);
+    // Searching from now on: until it looked for work, further
+    // submissions leave the other parked workers asleep
+    _searching.fetch_add(1, std::memory_order_seq_cst);
+    worker.notified = true;
+    worker.wakeup.notify_one();
+  }
+}
+
+bool ThreadPool::push(Task task) {
+  Worker *worker = current_worker();
+  // Tasks spawned by running tasks are still accepted while draining
+  if (_stop && !worker)
+    return false;
+
+  if (!worker || !worker->deque.push(task)) {
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    _shared.push_back(std::move(task));
+    _sharedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  notify(1);
+  return true;
+}
+
+void ThreadPool::enqueue_batch(std::vector<Task> &tasks) {
+  std::size_t count = tasks.size();
+  if (count == 0 || (_stop && !current_worker())) {
+    tasks.clear();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    for (auto &task : tasks)
+      _shared.push_back(std::move(task));
+    _sharedCount.fetch_add(count, std::memory_order_relaxed);
+  }
+  tasks.clear();
+  notify(count);
+}
+
+void ThreadPool::fork_join(std::size_t chunks,
+                           void (*run)(void *, std::size_t), void *context) {
+  if (chunks == 0)
+    return;
+  // One helper per worker at most; the caller runs chunks as well
+  std::size_t helpers = std::min(chunks, _workers.size() + 1) - 1;
+  if (helpers == 0) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+      run(context, chunk);
+    return;
+  }
+
+  auto state = std::make_shared<ForkJoin>(chunks, run, context);
+  std::vector<Task> tasks;
+  tasks.reserve(helpers);
+  for (std::size_t i = 0; i < helpers; ++i)
+    tasks.emplace_back([state]() { state->run_chunks(); });
+  enqueue_batch(tasks);
+
+  state->run_chunks();
+  // Only chunks already claimed by a helper remain; those are running
+  std::size_t done;
+  while ((done = state->done.load(std::memory_order_acquire)) != chunks)
+    state->done.wait(done, std::memory_order_acquire);
+  if (state->error)
+    std::rethrow_exception(state->error);
+}
+
+bool ThreadPool::run_pending_task(Worker &self) {
+  Task task;
+  if (!self.deque.pop(task) && !find_task(self, task))
+    return false;
+  task();
+  return true;
+}
+
+ThreadPool *ThreadPool::current(void) { return currentWorker.pool; }
+
+size_t ThreadPool::pending_tasks() const {
+  size_t count = _sharedCount.load(std::memory_order_relaxed);
+  for (const auto &worker : _workers)
+    count += worker->deque.size();
+  return count;
 }
 
 } // namespace fion::network
@@ -0,0 +1,81 @@
+#include "network/WorkStealingDeque.hpp"
+
+namespace fion::network {
+WorkStealingDeque::WorkStealingDeque(void)
+    : _slots(std::make_unique<Slot[]>(CAPACITY)) {
+  for (std::size_t i = 0; i < CAPACITY; ++i)
+    _slots[i].sequence.store(static_cast<std::int64_t>(i),
+                             std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::push(Task &task) {
+  std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+  Slot &slot = _slots[bottom & MASK];
+  // Not yet free for this lap: the ring is full, or a thief that claimed
+  // the previous occupant is still moving it out
+  if (slot.sequence.load(std::memory_order_acquire) != bottom)
+    return false;
+  slot.task = std::move(task);
+  slot.sequence.store(bottom + 1, std::memory_order_release);
+  _bottom.store(bottom + 1, std::memory_order_release);
+  return true;
+}
+
+bool WorkStealingDeque::pop(Task &out) {
+  std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+  _bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t top = _top.load(std::memory_order_relaxed);
+
+  if (top > bottom) {
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return false;
+  }
+  if (top == bottom) {
+    // Last task: race the thieves for it. Either way both ends move past
+    // this position, so the slot is next used one lap later.
+    bool won = _top.compare_exchange_strong(top, top + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    if (!won)
+      return false;
+    take(bottom, out, bottom + static_cast<std::int64_t>(CAPACITY));
+    return true;
+  }
+  // The next push reuses this position
+  take(bottom, out, bottom);
+  return true;
+}
+
+bool WorkStealingDeque::steal(Task &out) {
+  std::int64_t top = _top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t bottom = _bottom.load(std::memory_order_acquire);
+  if (top >= bottom)
+    return false;
+  if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed))
+    return false;
+  take(top, out, top + static_cast<std::int64_t>(CAPACITY));
+  return true;
+}
+
+void WorkStealingDeque::take(std::int64_t position, Task &out,
+                             std::int64_t next) {
+  Slot &slot = _slots[position & MASK];
+  // Filled before the position was published; wait out the rare case where
+  // that store is not visible yet
+  while (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+  }
+  out = std::move(slot.task);
+  slot.sequence.store(next, std::memory_order_release);
+}
+
+std::size_t WorkStealingDeque::size(void) const {
+  std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+  std::int64_t top = _top.load(std::memory_order_relaxed);
+  return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+}
+
+} // namespace fion::network
@@ -0,0 +1,86 @@
+/*
+ * fion_pack: build an AssetBundle pack from a directory
+ *
+ * Usage: fion_pack <directory> <output.pack>
+ *
+ * Every regular file below the directory is stored under its relative path.
+ * A sibling "<file>.gz" or "<file>.br" is stored as a precompressed variant
+ * of <file> instead of as an asset of its own.
+ */
+
+#include "AssetBundle.hpp"
+#include "StaticFileHandler.hpp"
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+std::string read_file(const fs::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Cannot read " + path.string());
+  std::ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+bool has_suffix(const std::string &value, const std::string &suffix) {
+  return value.size() > suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <directory> <output.pack>"
+              << std::endl;
+    return 2;
+  }
+
+  try {
+    const fs::path root(argv[1]);
+    std::map<std::string, fs::path> files;
+    for (const auto &entry : fs::recursive_directory_iterator(root)) {
+      if (entry.is_regular_file())
+        files.emplace(fs::relative(entry.path(), root).generic_string(),
+                      entry.path());
+    }
+
+    std::vector<fion::AssetBundle::Source> sources;
+    for (const auto &[relative, path] : files) {
+      // Precompressed siblings are attached to their identity file below
+      if ((has_suffix(relative, ".gz") &&
+           files.count(relative.substr(0, relative.size() - 3))) ||
+          (has_suffix(relative, ".br") &&
+           files.count(relative.substr(0, relative.size() - 3))))
+        continue;
+
+      fion::AssetBundle::Source source;
+      source.path = relative;
+      source.contentType = fion::StaticFileHandler::content_type_for(relative);
+      source.content = read_file(path);
+      if (auto gz = files.find(relative + ".gz"); gz != files.end())
+        source.gzip = read_file(gz->second);
+      if (auto br = files.find(relative + ".br"); br != files.end())
+        source.brotli = read_file(br->second);
+      sources.push_back(std::move(source));
+    }
+
+    std::size_t count = sources.size();
+    fion::AssetBundle::write(argv[2], std::move(sources));
+    std::cout << "fion_pack: wrote " << count << " assets to " << argv[2]
+              << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << "fion_pack: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}